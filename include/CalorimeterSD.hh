@@ -1,22 +1,18 @@
 /// \file B4/B4c/include/CalorimeterSD.hh
-/// \brief Definition of the B4c::CalorimeterSD class
+/// \brief Definition of the B4c::CalorimeterSD class template
 
 
 #ifndef B4cCalorimeterSD_h
 #define B4cCalorimeterSD_h 1
 
 
-#include "CalorHit.hh"
+#include "ScoringPolicies.hh"
 
 
 #include "G4VSensitiveDetector.hh"
 #include "globals.hh"
 
 
-#include <fstream>
-#include <set>
-
-
 class G4Step;
 class G4HCofThisEvent;
 class G4TouchableHistory;
@@ -25,12 +21,28 @@ class G4TouchableHistory;
 namespace B4c
 {
 
-
+/// Scoring-plane SD, specialized at compile time on what it scores and
+/// what it does with it.
+///
+/// ProcessHits finds the plane crossed (see ScoringParallelWorld), applies
+/// the scoring window and the once-per-plane rule and hands the crossing to
+/// the sink. Filter::Accept(const G4Track&) selects the particles;
+/// Sink is NullSink, HistogramSink, CsvRecordSink, BinaryRecordSink or a
+/// SinkPair of them (ScoringPolicies.hh). Each combination is its own class
+/// with the policy calls inlined, so the hot path has no branches for
+/// outputs a configuration does not use. The sinks are the only output:
+/// the SD has no hits collection.
+///
+/// The combinations are instantiated in CalorimeterSD.cc only; use
+/// CreateCalorimeterSD to get the one geometry.txt asks for.
+
+template<class Filter, class Sink>
 class CalorimeterSD : public G4VSensitiveDetector
 {
   public:
-    CalorimeterSD(const G4String& name, const G4String& hitsCollectionName, G4int nofCells);
-    ~CalorimeterSD() override;
+    CalorimeterSD(const G4String& name, G4int nofPlanes, G4double scoreEminMeV,
+                  G4double scoreEmaxMeV, Sink&& sink);
+    ~CalorimeterSD() override = default;
 
 
     void Initialize(G4HCofThisEvent* hitCollection) override;
@@ -39,14 +51,18 @@ class CalorimeterSD : public G4VSensitiveDetector
 
 
   private:
-    CalorHitsCollection* fHitsCollection = nullptr;
-    G4int fNofCells = 0;
+    G4int fNofPlanes = 0;
+    G4double fScoreEminMeV = 0.;
+    G4double fScoreEmaxMeV = DBL_MAX;
 
-
-    std::ofstream outputFile;
-    std::set<G4int> fLoggedTracks;
+    Filter fFilter;
+    Sink fSink;
 };
 
+/// The SD for this thread, for the scoring options of geometry.txt
+/// ("score", "spectra", "output"); called from ConstructSD
+G4VSensitiveDetector* CreateCalorimeterSD(const G4String& name);
+
 
 }  // namespace B4c
 
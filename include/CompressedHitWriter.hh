@@ -0,0 +1,124 @@
+/// \file B4/B4c/include/CompressedHitWriter.hh
+/// \brief Definition of the B4c::CompressedHitWriter class
+
+#ifndef B4cCompressedHitWriter_h
+#define B4cCompressedHitWriter_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace B4c
+{
+
+/// Block-compressed stream of scored photon records.
+///
+/// Replaces the per-thread CSV when per-photon records are needed. The
+/// constant columns of the CSV (Particle, Volume) are written once in the
+/// file header. Each record holds the event ID as a delta to the previous
+/// record, the track ID, the track-parent ID difference and the DetectorID
+/// (scoring plane) as varints, then the kinetic energy in MeV and the track
+/// weight as 32-bit floats. The weight is 1 in analog runs and carries the
+/// importance sampling and weight-window factors otherwise (version 3).
+///
+/// Records are collected in blocks that are compressed on their own
+/// (zstd or LZ4), and delta encoding restarts in every block, so blocks can
+/// be decoded independently and in parallel. A build without the requested
+/// codec writes the blocks uncompressed (codec none), so the output is
+/// never lost. Layout, all little endian:
+///
+///   file header : "B4CH" | u32 version | u32 codec | u32 length | text
+///   block       : "BLK1" | u32 records | u32 raw size | u32 compressed size
+///                 | i32 first event ID | payload
+///
+/// The header text is the CSV header line followed by the constant column
+/// values. plots/read_hits.py reads the format.
+
+class CompressedHitWriter
+{
+  public:
+    enum class Codec : std::uint32_t
+    {
+      none = 0,  ///< Stored blocks, always available
+      zstd = 1,
+      lz4 = 2
+    };
+
+    /// Whether the codec was found at build time
+    static G4bool IsAvailable(Codec codec);
+    static G4bool ParseCodec(const G4String& name, Codec& codec);
+
+    /// particle is the constant Particle column: "gamma", or the scored
+    /// particles when more than one kind is scored
+    CompressedHitWriter(const G4String& fileName, Codec codec, G4int level,
+                        const G4String& particle = "gamma", std::size_t recordsPerBlock = 65536);
+    ~CompressedHitWriter();
+
+    CompressedHitWriter(const CompressedHitWriter&) = delete;
+    CompressedHitWriter& operator=(const CompressedHitWriter&) = delete;
+
+    G4bool IsOpen() const { return fOut.is_open(); }
+
+    inline void Write(G4int eventID, G4int trackID, G4int parentID, G4double energyMeV,
+                      G4int detectorID, G4double weight);
+
+  private:
+    inline void PutVarint(std::uint64_t value);
+    void FlushBlock();
+
+    std::ofstream fOut;
+    Codec fCodec;
+    G4int fLevel = 1;
+    std::size_t fRecordsPerBlock = 0;
+
+    std::string fRaw;  ///< Uncompressed block being filled
+    std::vector<char> fCompressed;
+    std::uint32_t fNofRecords = 0;
+    G4int fFirstEventID = 0;
+    G4int fLastEventID = 0;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void CompressedHitWriter::PutVarint(std::uint64_t value)
+{
+  while (value >= 0x80) {
+    fRaw.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  fRaw.push_back(static_cast<char>(value));
+}
+
+inline void CompressedHitWriter::Write(G4int eventID, G4int trackID, G4int parentID,
+                                       G4double energyMeV, G4int detectorID,
+                                       G4double weight)
+{
+  if (fNofRecords == 0) {
+    fFirstEventID = eventID;
+    fLastEventID = eventID;
+  }
+
+  // Event IDs of one thread only grow; zigzag keeps a stray decrease valid
+  auto zigzag = [](std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+  };
+  PutVarint(zigzag(static_cast<std::int64_t>(eventID) - fLastEventID));
+  PutVarint(zigzag(trackID));
+  PutVarint(zigzag(static_cast<std::int64_t>(trackID) - parentID));
+  PutVarint(zigzag(detectorID));
+
+  auto energy = static_cast<float>(energyMeV);
+  fRaw.append(reinterpret_cast<const char*>(&energy), sizeof(energy));
+  auto weightF = static_cast<float>(weight);
+  fRaw.append(reinterpret_cast<const char*>(&weightF), sizeof(weightF));
+
+  fLastEventID = eventID;
+  if (++fNofRecords >= fRecordsPerBlock) FlushBlock();
+}
+
+}  // namespace B4c
+
+#endif
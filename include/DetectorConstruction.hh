@@ -7,32 +7,92 @@
 #include "G4LogicalVolume.hh"
 #include "globals.hh"
 
+#include <vector>
+
+class G4Material;
+
 namespace B4c {
 
+/// Target stack and scoring planes.
+///
+/// geometry.txt either gives a single foil ("material W", "thickness 0.1")
+/// or an ordered stack, one "layer <material> <thickness_mm>" line per layer,
+/// e.g. a W converter followed by B4C shielding. The layers touch; every
+/// interface (the back face of a layer) is a zero-thickness scoring plane in
+/// ScoringParallelWorld and has its own spectrum. At most kMaxLayers layers
+/// are built.
+
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
  public:
- DetectorConstruction() = default;
+ static constexpr std::size_t kMaxLayers = 64;  // TrackInformation keeps one bit per plane
+
+ struct Layer
+ {
+   G4Material* material = nullptr;
+   G4String label;  // e.g. W_0.1mm
+   G4double thickness = 0.;
+   G4double zFront = 0.;
+   G4double zBack = 0.;
+   G4LogicalVolume* logical = nullptr;
+ };
+
+ DetectorConstruction();
  ~DetectorConstruction() override = default;
 
  G4VPhysicalVolume* Construct() override;
- void ConstructSDandField() override;
 
  G4LogicalVolume* GetBremsVolume() const { return fBremsVolume; }
 
  G4String GetOutputFileName() const { return fOutputFileName; }
+ G4String GetSpectrumFileName() const { return fSpectrumFileName; }
+ const std::vector<G4String>& GetSpectrumLabels() const { return fSpectrumLabels; }
+ // Spectra split by photon origin: <label>_brems, <label>_fluo, ... per plane
+ G4String GetOriginSpectrumFileName() const { return fOriginSpectrumFileName; }
+ const std::vector<G4String>& GetOriginSpectrumLabels() const { return fOriginSpectrumLabels; }
+ // Fluence at the point detectors of /B4c/ned/ (PointDetectorStore)
+ G4String GetPointDetectorFileName() const { return fPointDetectorFileName; }
+ const std::vector<Layer>& GetLayers() const { return fLayers; }
  G4double GetThicknessMM() const { return fThicknessMM; }
  G4String GetMaterialName() const { return fMaterialName; }
 
+ // Scored particles: "gamma" or "charged" (geometry.txt: score)
+ G4String GetScoredParticles() const { return fScoredParticles; }
+ // Native spectra on or off (geometry.txt: spectra); off with output none
+ // leaves transport and the SD dispatch only
+ G4bool GetSpectraEnabled() const { return fSpectraEnabled; }
+
+ // Per-photon record output: "csv", "compressed" or "none"
+ G4String GetOutputFormat() const { return fOutputFormat; }
+ G4String GetOutputCodec() const { return fOutputCodec; }
+ G4int GetCompressionLevel() const { return fCompressionLevel; }
+
+ // Scoring window in MeV (geometry.txt: score_emin, score_emax)
+ G4double GetScoreEminMeV() const { return fScoreEminMeV; }
+ G4double GetScoreEmaxMeV() const { return fScoreEmaxMeV; }
+
  private:
- G4LogicalVolume* logicDetector = nullptr;
  G4LogicalVolume* logicTarget = nullptr;
  G4LogicalVolume* fBremsVolume = nullptr;
- G4double fTargetBackZ = 0;
 
  G4String fOutputFileName = "";
+ G4String fSpectrumFileName = "";
+ std::vector<G4String> fSpectrumLabels;  // one CSV column per interface, e.g. W_0.1mm
+ G4String fOriginSpectrumFileName = "";
+ std::vector<G4String> fOriginSpectrumLabels;  // plane-major, PhotonOrigin order
+ G4String fPointDetectorFileName = "";
+ std::vector<Layer> fLayers;
  G4double fThicknessMM = 0.0;
  G4String fMaterialName = "";
+
+ G4String fScoredParticles = "gamma";
+ G4bool fSpectraEnabled = true;
+ G4String fOutputFormat = "csv";
+ G4String fOutputCodec = "zstd";
+ G4int fCompressionLevel = 1;
+
+ G4double fScoreEminMeV = 0.;
+ G4double fScoreEmaxMeV = DBL_MAX;
 };
 
 } // namespace B4c
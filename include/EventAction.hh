@@ -5,9 +5,12 @@
 #ifndef B4cEventAction_h
 #define B4cEventAction_h 1
 
+#include "G4GenericMessenger.hh"
 #include "G4UserEventAction.hh"
 #include "globals.hh"
 
+#include <memory>
+
 class G4Event;
 
 namespace B4c
@@ -15,8 +18,15 @@ namespace B4c
 
 /// Event action class
 ///
-/// For now, this just prints event IDs at the end of each event.
-/// Later you can extend it to record scoring or analysis results.
+/// Prints event IDs at the end of each event.
+///
+/// With visualization enabled it also sub-samples the events sent to the
+/// vis manager, so an interactive session can run MT workers at full speed:
+/// only every /B4c/vis/drawEvery-th event a thread processes (counted by
+/// the thread, not by event ID) stores trajectories
+/// and is kept for drawing (vis.mac sets /vis/drawOnlyToBeKeptEvents), up to
+/// /B4c/vis/maxEvents per thread and run. All other events run without
+/// trajectories.
 class EventAction : public G4UserEventAction
 {
   public:
@@ -27,7 +37,15 @@ class EventAction : public G4UserEventAction
     void EndOfEventAction(const G4Event* event) override;
 
   private:
-    // Placeholder: add scoring IDs or counters here in the future
+    std::unique_ptr<G4GenericMessenger> fMessenger;
+    G4int fDrawEvery = 100;
+    G4int fMaxDrawnEvents = 50;
+
+    G4int fStoreTrajectory = -1;  ///< Mode set by the vis macros, -1 = not read yet
+    G4int fNofEvents = 0;  ///< Events of this thread in the current run
+    G4int fNofDrawnEvents = 0;
+    G4int fLastRunID = -1;
+    G4bool fDrawThisEvent = false;
 };
 
 }  // namespace B4c
@@ -0,0 +1,63 @@
+/// \file B4/B4c/include/PhotonOrigin.hh
+/// \brief Definition of the B4c::PhotonOriginClassifier class
+
+#ifndef B4cPhotonOrigin_h
+#define B4cPhotonOrigin_h 1
+
+#include "globals.hh"
+
+#include <utility>
+#include <vector>
+
+class G4Track;
+class G4VProcess;
+
+namespace B4c
+{
+
+/// How a scored photon was made
+enum PhotonOrigin : G4int
+{
+  kBremsstrahlung = 0,
+  kFluorescence,  ///< atomic de-excitation after phot, compt or ionisation
+  kAnnihilation,
+  kOtherOrigin,   ///< nuclear (e.g. n capture), primaries, anything else
+  kNofPhotonOrigins
+};
+
+/// Column suffix of an origin: brems, fluo, annihil, other
+const char* PhotonOriginLabel(G4int origin);
+
+/// Registry key of the per-origin spectrum of a scoring plane; the plain
+/// per-plane spectra use the plane index itself
+constexpr G4int kOriginSpectrumKey = 1000;
+constexpr G4int OriginSpectrumKey(G4int plane, G4int origin)
+{
+  return kOriginSpectrumKey + plane * kNofPhotonOrigins + origin;
+}
+
+/// Classifies photons by their creator process without string compares.
+///
+/// The origin of a creator process follows from its type and sub-type and is
+/// cached per process pointer, so after the first photon of each process a
+/// classification is a pointer compare. Photons whose creator is not the
+/// physics process (weight-window split copies) carry the origin of the
+/// original photon in TrackInformation, which takes precedence.
+/// One classifier per thread; it is not shared.
+
+class PhotonOriginClassifier
+{
+  public:
+    G4int Classify(const G4Track& track);
+
+  private:
+    static G4int FromProcess(const G4VProcess* process);
+
+    const G4VProcess* fLastProcess = nullptr;
+    G4int fLastOrigin = kOtherOrigin;
+    std::vector<std::pair<const G4VProcess*, G4int>> fCache;
+};
+
+}  // namespace B4c
+
+#endif
@@ -0,0 +1,51 @@
+/// \file B4/B4c/include/PhysicsTableCache.hh
+/// \brief Definition of the B4c::PhysicsTableCache class
+
+#ifndef B4cPhysicsTableCache_h
+#define B4cPhysicsTableCache_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+class G4VModularPhysicsList;
+
+namespace B4c
+{
+
+/// Local cache of EM physics tables.
+///
+/// The cache directory is keyed by physics list name, Geant4 version, the
+/// physics constructors registered in the list (the reference list's own
+/// and the ones added in main), the default production cuts, the
+/// production cuts and user-limit types of every region, and the set of
+/// materials in the geometry, so a change in any of them simply selects
+/// another directory.
+///
+/// The key can only be computed once the geometry and cuts are final, which
+/// is when the kernel enters G4State_Init to build the physics tables for a
+/// run. On a hit the tables are retrieved instead of built; on a miss they
+/// are stored once the run has been initialised (G4State_GeomClosed).
+
+class PhysicsTableCache : public G4VStateDependent
+{
+  public:
+    PhysicsTableCache(G4VModularPhysicsList* physicsList, const G4String& physicsListName,
+                      const G4String& baseDirectory = "physics_tables");
+    ~PhysicsTableCache() override = default;
+
+    G4bool Notify(G4ApplicationState requestedState) override;
+
+  private:
+    G4String ComputeKey() const;
+
+    G4VModularPhysicsList* fPhysicsList = nullptr;
+    G4String fPhysicsListName;
+    G4String fBaseDirectory;
+    G4String fDirectory;  ///< Directory selected for the current key
+    G4String fKey;
+    G4bool fStorePending = false;
+};
+
+}  // namespace B4c
+
+#endif
@@ -5,9 +5,12 @@
 #define B4PrimaryGeneratorAction_h 1
 
 #include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
 #include "G4ThreeVector.hh"
 #include "globals.hh"
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -18,6 +21,16 @@ namespace B4
 {
 
 /// PrimaryGeneratorAction: responsible for generating the initial particles for each event.
+///
+/// The primary energy is drawn from macros/spectrum_new.mac. Optionally it is
+/// drawn from a biased version q(E) = p(E) I(E) / norm instead, and the primary
+/// vertex carries the weight p/q, which every secondary and so every scored
+/// photon inherits. The importance I(E) is the product of
+///  - /B4c/gun/importanceFile: a step function, lines "E_MeV importance",
+///    each value holding from its energy up to the next line, and
+///  - /B4c/gun/tailFraction f with /B4c/gun/tailEnergy Et: a constant factor
+///    above Et chosen so that a fraction f of the primaries is drawn there.
+/// With neither set (the default) primaries are unweighted.
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
 public:
@@ -31,14 +44,30 @@ private:
   // Loads the energy spectrum (energy–probability pairs) from a text file
   void LoadSpectrum(const std::string& filename);
 
-  // Samples a random energy according to the loaded probability distribution
-  double SampleEnergy() const;
+  // Samples a random energy according to the (biased) probability distribution;
+  // weight is set to p/q of the sampled point
+  double SampleEnergy(G4double& weight) const;
+
+  // Builds the biased CDF and the per-point weights from the bias settings
+  void BuildBiasedSpectrum();
+  void SetTailEnergy(G4double energy);
+  void SetTailFraction(G4double fraction);
+  void SetImportanceFile(const G4String& fileName);
 
 private:
   G4GeneralParticleSource* fParticleGun;   // Geant4’s flexible particle source
   std::vector<double> fEnergies;           // Energies (in MeV)
   std::vector<double> fProbabilities;      // Corresponding probabilities
   std::vector<double> fCDF;                // Cumulative distribution for thread-safe sampling
+
+  // Importance sampling of the primary energy
+  std::unique_ptr<G4GenericMessenger> fMessenger;
+  G4double fTailEnergy = 1.0 * CLHEP::MeV;
+  G4double fTailFraction = 0.;             // 0 = no tail biasing
+  G4String fImportanceFile;                // empty = no importance function
+  G4bool fBiasDirty = false;
+  std::vector<double> fBiasedCDF;          // Empty unless biasing is active
+  std::vector<double> fWeights;            // p/q per spectrum point
 };
 
 } // namespace B4
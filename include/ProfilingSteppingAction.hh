@@ -0,0 +1,133 @@
+/// \file B4/B4c/include/ProfilingSteppingAction.hh
+/// \brief Definition of the B4c::ProfilingSteppingAction and B4c::StepProfiler classes
+
+#ifndef B4cProfilingSteppingAction_h
+#define B4cProfilingSteppingAction_h 1
+
+#include "G4GenericMessenger.hh"
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Track;
+class G4VProcess;
+
+namespace B4c
+{
+
+/// Step counts and sampled wall time of one thread, by particle type,
+/// volume (pre-step) and process (the one that limited the step).
+///
+/// Every step is counted; one step in /B4c/profile/sampleEvery is also
+/// timed, as the wall time from the end of the previous step of the same
+/// track to the end of this one (stepping, SD and secondaries included).
+/// The time of a key is estimated as its step count times its mean sampled
+/// step time. Keys are raw pointers, so the hot path has no strings.
+
+class ProfilingSteppingAction : public G4UserSteppingAction
+{
+  public:
+    ProfilingSteppingAction() = default;
+    ~ProfilingSteppingAction() override = default;
+
+    void UserSteppingAction(const G4Step* step) override;
+
+    void SetActive(G4bool active, G4int sampleEvery);
+
+    /// Add this thread's table to the StepProfiler and clear it
+    void MergeAndClear();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using Key = std::tuple<const G4ParticleDefinition*, const G4LogicalVolume*, const G4VProcess*>;
+    struct KeyHash
+    {
+      std::size_t operator()(const Key& key) const
+      {
+        auto h = std::hash<const void*>();
+        return h(std::get<0>(key)) ^ (h(std::get<1>(key)) * 31) ^ (h(std::get<2>(key)) * 961);
+      }
+    };
+    struct Entry
+    {
+      std::uint64_t steps = 0;
+      std::uint64_t sampledSteps = 0;
+      Clock::duration sampledTime{0};
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> fTable;
+    G4bool fActive = false;
+    G4int fSampleEvery = 100;
+    G4int fStepsToSample = 0;
+
+    // Sample in progress: timestamp at the end of the previous step
+    const G4Track* fSampledTrack = nullptr;
+    G4int fSampledStepNumber = 0;
+    Clock::time_point fSampleStart;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Optional CPU-cost profiler, shared by all threads.
+///
+///   /B4c/profile/enable true    profile the following runs
+///   /B4c/profile/sampleEvery 100
+///   /B4c/profile/top 25         lines of the ranked report
+///
+/// Without /B4c/profile/enable no stepping action is registered at all, so
+/// production runs pay nothing. Once enabled, every worker installs a
+/// ProfilingSteppingAction at the start of the next run; switching it off
+/// again leaves one early return per step. Workers merge their tables at
+/// the end of the run and the master prints a ranked report and writes
+/// data/step_profile.csv.
+
+class StepProfiler
+{
+  public:
+    static StepProfiler& Instance();
+
+    /// Called by RunAction on every thread
+    void BeginOfRun(G4bool isMaster);
+    void EndOfRun(G4bool isMaster);
+
+    void Merge(const G4String& particle, const G4String& volume, const G4String& process,
+               std::uint64_t steps, std::uint64_t sampledSteps, G4double sampledSeconds);
+
+  private:
+    StepProfiler();
+
+    void Report() const;
+
+    struct Stats
+    {
+      std::uint64_t steps = 0;
+      std::uint64_t sampledSteps = 0;
+      G4double sampledSeconds = 0.;
+      G4double EstimatedSeconds() const
+      {
+        return sampledSteps > 0 ? steps * sampledSeconds / sampledSteps : 0.;
+      }
+    };
+
+    std::unique_ptr<G4GenericMessenger> fMessenger;
+    G4bool fEnabled = false;
+    G4int fSampleEvery = 100;
+    G4int fTop = 25;
+
+    mutable std::mutex fMutex;
+    std::map<std::tuple<G4String, G4String, G4String>, Stats> fStats;
+};
+
+}  // namespace B4c
+
+#endif
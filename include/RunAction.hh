@@ -30,10 +30,19 @@
 #ifndef B4RunAction_h
 #define B4RunAction_h 1
 
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
 #include "G4UserRunAction.hh"
 
+#include <memory>
+
 class G4Run;
 
+namespace B4c
+{
+class SpectrumSnapshotWriter;
+}
+
 namespace B4
 {
 
@@ -54,15 +63,27 @@ namespace B4
 /// In EndOfRunAction(), the accumulated statistic and computed
 /// dispersion is printed.
 ///
+/// On the master, the photon spectrum scored by the sensitive detectors is
+/// merged and written to data/spectrum_<material>_<thickness>mm.csv (one
+/// column per scoring plane) at the end of the run and, every /B4c/run/snapshotInterval while the run is in
+/// progress, replaced atomically by a background writer. Every bin carries
+/// its statistical uncertainty, and optionally a batch-means estimate
+/// (/B4c/run/batchSize).
 
 class RunAction : public G4UserRunAction
 {
   public:
     RunAction();
-    ~RunAction() override = default;
+    ~RunAction() override;
 
     void BeginOfRunAction(const G4Run*) override;
     void EndOfRunAction(const G4Run*) override;
+
+  private:
+    std::unique_ptr<G4GenericMessenger> fMessenger;
+    std::unique_ptr<B4c::SpectrumSnapshotWriter> fSnapshotWriter;
+    G4double fSnapshotInterval = 60. * CLHEP::s;  ///< 0 disables snapshots
+    G4int fBatchSize = 0;  ///< Events per batch for batch-means errors, 0 = off
 };
 
 }  // namespace B4
@@ -0,0 +1,64 @@
+/// \file B4/B4c/include/ScoringParallelWorld.hh
+/// \brief Definition of the B4c::ScoringParallelWorld class
+
+#ifndef B4cScoringParallelWorld_h
+#define B4cScoringParallelWorld_h 1
+
+#include "G4VUserParallelWorld.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4LogicalVolume;
+
+namespace B4c
+{
+
+class DetectorConstruction;
+
+/// Zero-thickness scoring planes at the layer interfaces, in a parallel
+/// world, so the mass geometry is only the world and the layer stack.
+///
+/// The parallel world is cut along z into slabs whose faces are the
+/// interfaces: slab k covers layer k, and one more slab lies behind the
+/// last layer. Interface i is the +z face of slab i and the -z face of
+/// slab i + 1, so CalorimeterSD (attached to the slabs) scores a photon
+/// on the step that leaves a slab through either z face, in the 2 x 2 cm
+/// the old 1 um vacuum planes covered. Crossing an interface costs one step
+/// limit in the parallel navigator instead of two steps through a real
+/// volume. Scoring the crossing step itself, not the first step behind the
+/// plane, keeps the full weight of the photon when a weight window splits
+/// or plays roulette with it at the end of that step.
+///
+/// With n layers there are n planes (0 .. n-1) and n + 1 slabs, so the
+/// copy - 1 / copy mapping of the exit face gives -1 .. n. The two outer
+/// faces are not interfaces:
+///   - the -z face of slab 0 (the front of the stack) gives -1;
+///   - the +z face of the trailing slab n, 1 cm behind the stack, gives n.
+///     Every photon that leaves the stack forwards exits there, but it has
+///     already been scored on the last interface.
+/// CalorimeterSD drops both by the 0 .. n-1 range check. The last
+/// interface itself is scored in both directions: forwards as the +z face
+/// of slab n - 1, backwards as the -z face of slab n, both plane n - 1.
+///
+/// Needs G4ParallelWorldPhysics(kWorldName) in the physics list.
+
+class ScoringParallelWorld : public G4VUserParallelWorld
+{
+  public:
+    static constexpr const char* kWorldName = "ScoringWorld";
+
+    explicit ScoringParallelWorld(const DetectorConstruction* detector);
+    ~ScoringParallelWorld() override = default;
+
+    void Construct() override;
+    void ConstructSD() override;
+
+  private:
+    const DetectorConstruction* fDetector = nullptr;
+    std::vector<G4LogicalVolume*> fSlabLogicals;
+};
+
+}  // namespace B4c
+
+#endif
@@ -0,0 +1,215 @@
+/// \file B4/B4c/include/ScoringPolicies.hh
+/// \brief Filter and sink policies of the B4c::CalorimeterSD template
+
+#ifndef B4cScoringPolicies_h
+#define B4cScoringPolicies_h 1
+
+#include "CompressedHitWriter.hh"
+#include "PhotonOrigin.hh"
+#include "SpectrumRegistry.hh"
+
+#include "G4Gamma.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Track.hh"
+#include "globals.hh"
+
+#include <fstream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace B4c
+{
+
+/// One particle crossing a scoring plane, as handed to a sink
+struct Crossing
+{
+  const G4Track* track;
+  G4int plane;
+  G4double energyMeV;
+  G4double weight;
+};
+
+// Filter policies: which particles are scored. kParticleLabel is the
+// constant Particle column of the binary records; kPhotonOrigins tells
+// HistogramSink whether spectra by photon origin mean anything.
+
+class GammaFilter
+{
+  public:
+    static constexpr const char* kParticleLabel = "gamma";
+    static constexpr G4bool kPhotonOrigins = true;
+    G4bool Accept(const G4Track& track) const { return track.GetDefinition() == fGamma; }
+
+  private:
+    const G4ParticleDefinition* fGamma = G4Gamma::Definition();
+};
+
+class ChargedFilter
+{
+  public:
+    static constexpr const char* kParticleLabel = "charged";
+    static constexpr G4bool kPhotonOrigins = false;
+    G4bool Accept(const G4Track& track) const
+    {
+      return track.GetDefinition()->GetPDGCharge() != 0.;
+    }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Sink policies: what is done with a scored crossing. A sink is complete
+// when it is constructed (files open), so Record() has no checks.
+
+/// Scores nothing: transport and the SD dispatch only, for benchmarks
+class NullSink
+{
+  public:
+    void BeginOfEvent(G4int /*eventID*/) {}
+    void Record(const Crossing& /*crossing*/) {}
+    void EndOfEvent() {}
+};
+
+/// Native spectra of SpectrumRegistry, per plane, and per plane and photon
+/// origin when the filter scores photons
+template<class Filter>
+class HistogramSink
+{
+  public:
+    explicit HistogramSink(G4int nofPlanes);
+
+    void BeginOfEvent(G4int /*eventID*/) {}
+    inline void Record(const Crossing& crossing);
+    void EndOfEvent();
+
+  private:
+    std::vector<ThreadSpectrum*> fSpectra;  ///< This thread's spectra (MeV), per plane
+    std::vector<ThreadSpectrum*> fOriginSpectra;  ///< Per plane and PhotonOrigin
+    PhotonOriginClassifier fOriginClassifier;
+};
+
+/// Per-thread CSV records (EventID,TrackID,ParentID,Particle,...,Weight)
+class CsvRecordSink
+{
+  public:
+    /// out must be open; the header line is written here
+    explicit CsvRecordSink(std::ofstream&& out);
+
+    void BeginOfEvent(G4int eventID) { fEventID = eventID; }
+    inline void Record(const Crossing& crossing);
+    void EndOfEvent() {}
+
+  private:
+    std::ofstream fOut;
+    G4int fEventID = 0;
+
+    // Particle name of the last definition seen, so the name is looked up
+    // once per change of particle type, not per record
+    const G4ParticleDefinition* fLastParticle = nullptr;
+    const G4String* fLastParticleName = nullptr;
+};
+
+/// Per-thread block-compressed records (CompressedHitWriter)
+class BinaryRecordSink
+{
+  public:
+    /// writer must be open
+    explicit BinaryRecordSink(std::unique_ptr<CompressedHitWriter> writer)
+      : fWriter(std::move(writer))
+    {}
+
+    void BeginOfEvent(G4int eventID) { fEventID = eventID; }
+    void Record(const Crossing& crossing)
+    {
+      fWriter->Write(fEventID, crossing.track->GetTrackID(), crossing.track->GetParentID(),
+                     crossing.energyMeV, crossing.plane, crossing.weight);
+    }
+    void EndOfEvent() {}
+
+  private:
+    std::unique_ptr<CompressedHitWriter> fWriter;
+    G4int fEventID = 0;
+};
+
+/// Two sinks fed with the same crossings, e.g. spectra and records
+template<class First, class Second>
+class SinkPair
+{
+  public:
+    SinkPair(First&& first, Second&& second)
+      : fFirst(std::move(first)), fSecond(std::move(second))
+    {}
+
+    void BeginOfEvent(G4int eventID)
+    {
+      fFirst.BeginOfEvent(eventID);
+      fSecond.BeginOfEvent(eventID);
+    }
+    void Record(const Crossing& crossing)
+    {
+      fFirst.Record(crossing);
+      fSecond.Record(crossing);
+    }
+    void EndOfEvent()
+    {
+      fFirst.EndOfEvent();
+      fSecond.EndOfEvent();
+    }
+
+  private:
+    First fFirst;
+    Second fSecond;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+template<class Filter>
+HistogramSink<Filter>::HistogramSink(G4int nofPlanes)
+{
+  // One spectrum per scoring plane (= layer interface), and for photons one
+  // per plane and origin
+  auto& registry = SpectrumRegistry::Instance();
+  for (G4int plane = 0; plane < nofPlanes; ++plane) {
+    fSpectra.push_back(registry.CreateThreadSpectrum(plane));
+    if constexpr (Filter::kPhotonOrigins) {
+      for (G4int origin = 0; origin < kNofPhotonOrigins; ++origin)
+        fOriginSpectra.push_back(registry.CreateThreadSpectrum(OriginSpectrumKey(plane, origin)));
+    }
+  }
+}
+
+template<class Filter>
+inline void HistogramSink<Filter>::Record(const Crossing& crossing)
+{
+  fSpectra[crossing.plane]->Fill(crossing.energyMeV, crossing.weight);
+  if constexpr (Filter::kPhotonOrigins) {
+    G4int origin = fOriginClassifier.Classify(*crossing.track);
+    fOriginSpectra[crossing.plane * kNofPhotonOrigins + origin]->Fill(crossing.energyMeV,
+                                                                      crossing.weight);
+  }
+}
+
+template<class Filter>
+void HistogramSink<Filter>::EndOfEvent()
+{
+  for (auto* spectrum : fSpectra)
+    spectrum->EndOfEvent();
+  for (auto* spectrum : fOriginSpectra)
+    spectrum->EndOfEvent();
+}
+
+inline void CsvRecordSink::Record(const Crossing& crossing)
+{
+  const G4ParticleDefinition* particle = crossing.track->GetDefinition();
+  if (particle != fLastParticle) {
+    fLastParticle = particle;
+    fLastParticleName = &particle->GetParticleName();
+  }
+  fOut << fEventID << "," << crossing.track->GetTrackID() << ","
+       << crossing.track->GetParentID() << "," << *fLastParticleName << ","
+       << crossing.energyMeV << ",Detector," << crossing.plane << "," << crossing.weight << "\n";
+}
+
+}  // namespace B4c
+
+#endif
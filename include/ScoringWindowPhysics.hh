@@ -0,0 +1,36 @@
+/// \file B4/B4c/include/ScoringWindowPhysics.hh
+/// \brief Definition of the B4c::ScoringWindowPhysics class
+
+#ifndef B4cScoringWindowPhysics_h
+#define B4cScoringWindowPhysics_h 1
+
+#include "G4VPhysicsConstructor.hh"
+#include "globals.hh"
+
+namespace B4c
+{
+
+/// Adds G4UserSpecialCuts to photons and electrons, so the minimum kinetic
+/// energy of the G4UserLimits that DetectorConstruction attaches for the
+/// scoring window (geometry.txt: score_emin) stops them early.
+///
+/// A photon or electron below the window can only give photons below the
+/// window, so the scored spectrum above threshold is unchanged. Positrons
+/// are left alone, because their annihilation photons must still be
+/// produced. Neutrons are left alone too, because a slow neutron can still
+/// give a capture gamma in the scored window (e.g. 478 keV from 10B in B4C).
+/// Without user limits in a volume the process never triggers.
+
+class ScoringWindowPhysics : public G4VPhysicsConstructor
+{
+  public:
+    ScoringWindowPhysics() : G4VPhysicsConstructor("ScoringWindow") {}
+    ~ScoringWindowPhysics() override = default;
+
+    void ConstructParticle() override {}
+    void ConstructProcess() override;
+};
+
+}  // namespace B4c
+
+#endif
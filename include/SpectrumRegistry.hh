@@ -0,0 +1,154 @@
+/// \file B4/B4c/include/SpectrumRegistry.hh
+/// \brief Definition of the B4c::ThreadSpectrum and B4c::SpectrumRegistry classes
+
+#ifndef B4cSpectrumRegistry_h
+#define B4cSpectrumRegistry_h 1
+
+#include "globals.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace B4c
+{
+
+/// Photon energy spectrum filled by one thread.
+///
+/// Fills of an event go to a private scratch histogram; at the end of the
+/// event every touched bin adds its event total x to the sum of weights and
+/// x*x to the sum of squared weights. The squares are therefore taken per
+/// history, which keeps the variance estimate right when one primary puts
+/// several photons in the same bin.
+///
+/// The accumulated sums are atomics with a single writer (the owning
+/// thread), updated with a relaxed load and store, so the master can read a
+/// snapshot at any time while the run is in progress. Once the workers have
+/// finished the run the values are exact.
+///
+/// With a batch size set, the per-bin sums of every complete batch of events
+/// are also kept, for batch-means variance estimates.
+
+class ThreadSpectrum
+{
+  public:
+    ThreadSpectrum(G4int nofBins, G4double emin, G4double emax);
+    ~ThreadSpectrum() = default;
+
+    inline void Fill(G4double energy, G4double weight = 1.);
+    void EndOfEvent();
+
+    G4int GetNofBins() const { return fNofBins; }
+    G4double GetSumW(G4int i) const { return fSumW[i].load(std::memory_order_relaxed); }
+    G4double GetSumW2(G4int i) const { return fSumW2[i].load(std::memory_order_relaxed); }
+    G4long GetNofEvents() const { return fNofEvents.load(std::memory_order_relaxed); }
+
+    /// Append the completed batches to the given list
+    void CopyBatches(std::vector<std::vector<G4double>>& batches) const;
+
+    /// Zero everything; only called while the owning thread is idle
+    void Reset(G4int batchSize);
+
+  private:
+    static void Add(std::atomic<G4double>& sum, G4double value)
+    {
+      sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    G4int fNofBins = 0;
+    G4double fEmin = 0.;
+    G4double fEmax = 0.;
+    G4double fInvBinWidth = 0.;
+
+    std::unique_ptr<std::atomic<G4double>[]> fSumW;
+    std::unique_ptr<std::atomic<G4double>[]> fSumW2;
+    std::atomic<G4long> fNofEvents{0};
+
+    // Current event, touched by the owning thread only
+    std::vector<G4double> fEventBins;
+    std::vector<G4int> fTouchedBins;
+
+    // Batch means
+    G4int fBatchSize = 0;
+    G4int fEventsInBatch = 0;
+    std::vector<G4double> fBatchBins;
+    mutable std::mutex fBatchMutex;  ///< Taken once per batch, never per fill
+    std::vector<std::vector<G4double>> fBatches;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Merged content of all thread spectra
+struct MergedSpectrum
+{
+  std::vector<G4double> sumW;
+  std::vector<G4double> sumW2;
+  G4long nofEvents = 0;
+  G4int batchSize = 0;
+  std::vector<std::vector<G4double>> batches;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Process-wide list of the per-thread spectra.
+///
+/// The sensitive detector of every thread asks for its own ThreadSpectrum
+/// per key: the scoring plane, or a per-origin key of it (PhotonOrigin.hh);
+/// the master merges them, either periodically for a snapshot or once at the
+/// end of the run. Sums are merged by addition and batches by concatenation,
+/// so the merge is exact. The registry owns the spectra so the master can
+/// still read them after a worker has torn down its detector.
+/// The default binning (2 keV up to 10 MeV) matches plot_all_materials.py.
+
+class SpectrumRegistry
+{
+  public:
+    static SpectrumRegistry& Instance();
+
+    /// Binning used by spectra created from now on
+    void SetBinning(G4int nofBins, G4double emin, G4double emax);
+
+    ThreadSpectrum* CreateThreadSpectrum(G4int key = 0);
+
+    /// Zero all spectra, called by the master before the workers start a run.
+    /// A batch size > 0 also records batch sums every batchSize events.
+    void Reset(G4int batchSize = 0);
+
+    void Merge(G4int key, MergedSpectrum& merged) const;
+
+    /// Write the merged spectra of the keys firstKey, firstKey + 1, ... in
+    /// the binned_<material>.csv layout, one column per key labelled by
+    /// columnLabels, each followed by its uncertainty <label>_err (and
+    /// <label>_batch_err when batches are recorded). The file is replaced
+    /// atomically (temporary file, then rename).
+    G4bool WriteCSV(const G4String& fileName, const std::vector<G4String>& columnLabels,
+                    G4int firstKey = 0) const;
+
+  private:
+    SpectrumRegistry() = default;
+
+    mutable std::mutex fMutex;  ///< Guards the list, never the fills
+    std::vector<std::pair<G4int, std::unique_ptr<ThreadSpectrum>>> fSpectra;  ///< key, spectrum
+    G4int fNofBins = 5000;
+    G4double fEmin = 0.;
+    G4double fEmax = 10.;  ///< MeV
+    G4int fBatchSize = 0;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void ThreadSpectrum::Fill(G4double energy, G4double weight)
+{
+  if (energy < fEmin || energy > fEmax || weight == 0.) return;
+  auto i = static_cast<G4int>((energy - fEmin) * fInvBinWidth);
+  if (i >= fNofBins) i = fNofBins - 1;  // upper edge belongs to the last bin
+  if (fEventBins[i] == 0.) fTouchedBins.push_back(i);
+  fEventBins[i] += weight;
+}
+
+}  // namespace B4c
+
+#endif
@@ -0,0 +1,47 @@
+/// \file B4/B4c/include/SpectrumSnapshotWriter.hh
+/// \brief Definition of the B4c::SpectrumSnapshotWriter class
+
+#ifndef B4cSpectrumSnapshotWriter_h
+#define B4cSpectrumSnapshotWriter_h 1
+
+#include "globals.hh"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace B4c
+{
+
+/// Background thread of the master that periodically merges the per-thread
+/// spectra of the SpectrumRegistry and replaces a snapshot file, so a long
+/// run can be followed (and killed early) while it is in progress.
+/// The workers are never blocked: they keep filling their own spectra.
+
+class SpectrumSnapshotWriter
+{
+  public:
+    SpectrumSnapshotWriter(const G4String& fileName, const std::vector<G4String>& columnLabels,
+                           G4double intervalSeconds);
+    ~SpectrumSnapshotWriter();
+
+    SpectrumSnapshotWriter(const SpectrumSnapshotWriter&) = delete;
+    SpectrumSnapshotWriter& operator=(const SpectrumSnapshotWriter&) = delete;
+
+  private:
+    void Loop();
+
+    G4String fFileName;
+    std::vector<G4String> fColumnLabels;
+    G4double fIntervalSeconds = 0.;
+
+    std::mutex fMutex;
+    std::condition_variable fWakeUp;
+    G4bool fStop = false;
+    std::thread fThread;
+};
+
+}  // namespace B4c
+
+#endif
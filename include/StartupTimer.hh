@@ -0,0 +1,50 @@
+/// \file B4/B4c/include/StartupTimer.hh
+/// \brief Definition of the B4c::StartupTimer class
+
+#ifndef B4cStartupTimer_h
+#define B4cStartupTimer_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+namespace B4c
+{
+
+/// Wall-clock report of the startup phases.
+///
+/// main() marks the phases it controls directly (run manager creation,
+/// user initialisations, visualization). The initialisation and the
+/// physics-table build of the first run are picked up from the application
+/// state transitions. The report is printed once, when the first run
+/// closes the geometry and starts the event loop.
+
+class StartupTimer : public G4VStateDependent
+{
+  public:
+    StartupTimer();
+    ~StartupTimer() override = default;
+
+    /// Close the current phase under the given label
+    void Mark(const G4String& phase);
+
+    G4bool Notify(G4ApplicationState requestedState) override;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    void Report() const;
+
+    Clock::time_point fStart;
+    Clock::time_point fLast;
+    std::vector<std::pair<G4String, G4double>> fPhases;  ///< label, seconds
+    G4bool fRunInitialization = false;  ///< Idle -> Init seen, i.e. inside beamOn
+    G4bool fReported = false;
+};
+
+}  // namespace B4c
+
+#endif
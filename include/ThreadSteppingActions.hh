@@ -0,0 +1,22 @@
+/// \file B4/B4c/include/ThreadSteppingActions.hh
+/// \brief Definition of B4c::AddThreadSteppingAction
+
+#ifndef B4cThreadSteppingActions_h
+#define B4cThreadSteppingActions_h 1
+
+class G4UserSteppingAction;
+
+namespace B4c
+{
+
+/// Adds a stepping action to the event loop of this thread, between runs.
+///
+/// The optional tools (step profiler, point detectors, ...) register their
+/// stepping action only when they are switched on, so production runs have
+/// none. The first one is installed directly; when a second one comes, both
+/// move into a G4MultiSteppingAction. The stepping manager owns the actions.
+void AddThreadSteppingAction(G4UserSteppingAction* action);
+
+}  // namespace B4c
+
+#endif
@@ -0,0 +1,188 @@
+/// \file B4/B4c/include/TracingSteppingAction.hh
+/// \brief Definition of the B4c::TracingSteppingAction and B4c::EventTracer classes
+
+#ifndef B4cTracingSteppingAction_h
+#define B4cTracingSteppingAction_h 1
+
+#include "G4GenericMessenger.hh"
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class G4ParticleDefinition;
+
+namespace B4c
+{
+
+/// One step of a traced event, as stored in the ring buffer and written to
+/// the .b4t files (native byte order, read by plots/read_trace.py).
+/// Names are indices into the particle, volume and process tables of the
+/// buffer; energies in MeV, the post-step position in mm.
+struct TraceRecord
+{
+  std::int32_t eventID;
+  std::int32_t trackID;
+  std::int32_t parentID;
+  std::int32_t stepNumber;
+  std::uint16_t particle;
+  std::uint16_t volume;  ///< Pre-step logical volume
+  std::uint16_t process;  ///< Process that limited the step
+  std::int16_t copyNo;  ///< Pre-step copy number
+  std::uint32_t flags;  ///< TraceFlag bits, set on the first record of an event
+  float preEnergy;
+  float postEnergy;
+  float edep;
+  float x, y, z;
+  float weight;
+};
+static_assert(sizeof(TraceRecord) == 56, "TraceRecord is read with a fixed layout");
+
+enum TraceFlag : std::uint32_t
+{
+  kTraceEventStart = 1u << 0,
+  kTraceSampled = 1u << 1,  ///< Kept by /B4c/trace/sampleEvery
+  kTraceTriggered = 1u << 2,  ///< Kept by /B4c/trace/trigger
+  kTraceTruncated = 1u << 3  ///< More steps than the buffer holds; the first ones are kept
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Fixed-size ring of the traced steps of one thread: when it is full, the
+/// oldest events are overwritten. Owned by the EventTracer, so the master
+/// can write it between runs; only its own thread touches it during a run.
+
+class TraceBuffer
+{
+  public:
+    TraceBuffer(G4int threadID, std::size_t capacity);
+
+    G4int GetThreadID() const { return fThreadID; }
+    std::size_t GetCapacity() const { return fRing.size(); }
+    std::size_t GetSize() const { return fSize; }
+    std::uint64_t GetNofEvents() const { return fNofEvents; }
+
+    void Clear();
+    void Resize(std::size_t capacity);
+
+    /// Append one event, oldest records first
+    void Append(const std::vector<TraceRecord>& records);
+
+    /// Index of a name in a table, added on first use
+    std::uint16_t ParticleIndex(const G4String& name) { return Index(fParticles, name); }
+    std::uint16_t VolumeIndex(const G4String& name) { return Index(fVolumes, name); }
+    std::uint16_t ProcessIndex(const G4String& name) { return Index(fProcesses, name); }
+
+    G4bool Write(const G4String& fileName) const;
+
+  private:
+    static std::uint16_t Index(std::vector<G4String>& table, const G4String& name);
+
+    G4int fThreadID;
+    std::vector<TraceRecord> fRing;
+    std::size_t fHead = 0;  ///< Next record written
+    std::size_t fSize = 0;
+    std::uint64_t fNofEvents = 0;
+    std::vector<G4String> fParticles, fVolumes, fProcesses;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Records every step of the selected events of one thread.
+///
+/// The selection is made at the start of the event: with sampling only, a
+/// non-selected event costs one early return per step. With a trigger, any
+/// event may turn out to be wanted, so all steps are staged and the event
+/// is dropped at its end unless a photon above the trigger energy was
+/// scored on a plane.
+
+class TracingSteppingAction : public G4UserSteppingAction
+{
+  public:
+    explicit TracingSteppingAction(TraceBuffer* buffer);
+    ~TracingSteppingAction() override = default;
+
+    void UserSteppingAction(const G4Step* step) override;
+
+    void SetSelection(G4int sampleEvery, G4double triggerEnergy);
+    void BeginOfEvent(G4int eventID);
+    void EndOfEvent();
+
+  private:
+    TraceBuffer* fBuffer;
+    G4int fSampleEvery = 0;
+    G4double fTriggerEnergy = 0.;
+    const G4ParticleDefinition* fGamma = nullptr;
+
+    // Event in progress
+    G4bool fRecording = false;
+    G4bool fSampled = false;
+    G4bool fTriggered = false;
+    G4bool fTruncated = false;
+    G4int fEventID = 0;
+    std::vector<TraceRecord> fEvent;
+
+    // Name indices by pointer, so the hot path has no string lookups
+    std::unordered_map<const void*, std::uint16_t> fParticleIndex, fVolumeIndex, fProcessIndex;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Sampled step histories of whole events, shared by all threads:
+///
+///   /B4c/trace/sampleEvery 1000      trace one event in N (0 = off)
+///   /B4c/trace/trigger 5 MeV         trace events scoring a photon above E (0 = off)
+///   /B4c/trace/bufferSize 262144     steps kept per thread
+///   /B4c/trace/dump                  write the buffers now
+///
+/// With both selections off no stepping action is registered. Otherwise
+/// every worker registers a TracingSteppingAction at the start of the next
+/// run and keeps the traced events in its TraceBuffer, cleared at the start
+/// of every run and written at its end to data/trace_t<thread>.b4t.
+///
+/// During a run, SIGUSR1 makes every worker write its buffer at the end of
+/// its current event, so a long production run can be inspected while it
+/// runs (kill -USR1 <pid>).
+///
+/// The settings are master-only: the commands are not broadcast, the
+/// workers only read them between runs.
+
+class EventTracer
+{
+  public:
+    static EventTracer& Instance();
+
+    /// Called by RunAction and EventAction on every thread
+    void BeginOfRun(G4bool isMaster);
+    void BeginOfEvent(G4int eventID);
+    void EndOfEvent();
+    void EndOfRun(G4bool isMaster);
+
+    /// Write all buffers (between runs) or request a write from the workers
+    void Dump();
+
+    static G4String FileName(G4int threadID);
+
+  private:
+    EventTracer();
+
+    G4bool IsEnabled() const { return fSampleEvery > 0 || fTriggerEnergy > 0.; }
+    static G4bool WriteBuffer(const TraceBuffer& buffer);
+
+    std::unique_ptr<G4GenericMessenger> fMessenger;
+    G4int fSampleEvery = 0;
+    G4double fTriggerEnergy = 0.;
+    G4int fBufferSize = 262144;
+
+    std::mutex fMutex;
+    std::vector<std::unique_ptr<TraceBuffer>> fBuffers;  ///< One per thread
+    G4bool fSignalHandlerInstalled = false;
+};
+
+}  // namespace B4c
+
+#endif
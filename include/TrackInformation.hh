@@ -0,0 +1,68 @@
+/// \file B4/B4c/include/TrackInformation.hh
+/// \brief Definition of the B4c::TrackInformation class
+
+#ifndef B4cTrackInformation_h
+#define B4cTrackInformation_h 1
+
+#include "G4Allocator.hh"
+#include "G4Threading.hh"
+#include "G4VUserTrackInformation.hh"
+#include "globals.hh"
+
+#include <cstdint>
+
+namespace B4c
+{
+
+/// Per-track user information.
+///
+/// Attached to a track the first time it is scored, so a track that steps
+/// through a scoring plane several times is counted once per plane without
+/// the sensitive detector keeping any per-event container (one bit per
+/// plane). The track owns and deletes it; allocation goes through a
+/// thread-local G4Allocator.
+///
+/// Weight-window split copies also carry the photon origin of the original
+/// here, since their creator process is the weight window (PhotonOrigin).
+
+class TrackInformation : public G4VUserTrackInformation
+{
+  public:
+    TrackInformation() = default;
+    ~TrackInformation() override = default;
+
+    inline void* operator new(size_t);
+    inline void operator delete(void*);
+
+    G4bool IsScored(G4int plane) const { return (fScoredPlanes >> plane) & 1u; }
+    void SetScored(G4int plane) { fScoredPlanes |= std::uint64_t(1) << plane; }
+    G4bool IsScoredOnAnyPlane() const { return fScoredPlanes != 0; }
+
+    G4int GetOrigin() const { return fOrigin; }  ///< -1 = from the creator process
+    void SetOrigin(G4int origin) { fOrigin = origin; }
+
+  private:
+    std::uint64_t fScoredPlanes = 0;
+    G4int fOrigin = -1;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+extern G4ThreadLocal G4Allocator<TrackInformation>* TrackInformationAllocator;
+
+inline void* TrackInformation::operator new(size_t)
+{
+  if (!TrackInformationAllocator) {
+    TrackInformationAllocator = new G4Allocator<TrackInformation>;
+  }
+  return (void*)TrackInformationAllocator->MallocSingle();
+}
+
+inline void TrackInformation::operator delete(void* info)
+{
+  TrackInformationAllocator->FreeSingle((TrackInformation*)info);
+}
+
+}  // namespace B4c
+
+#endif
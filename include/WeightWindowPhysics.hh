@@ -0,0 +1,30 @@
+/// \file B4/B4c/include/WeightWindowPhysics.hh
+/// \brief Definition of the B4c::WeightWindowPhysics class
+
+#ifndef B4cWeightWindowPhysics_h
+#define B4cWeightWindowPhysics_h 1
+
+#include "G4VPhysicsConstructor.hh"
+#include "globals.hh"
+
+namespace B4c
+{
+
+/// Adds WeightWindowProcess to photons, electrons and positrons, invoked
+/// after all other post-step processes. The windows are set from macros
+/// (/B4c/ww/..., see WeightWindowStore); creating the constructor on the
+/// master creates those commands. Without windows nothing changes.
+
+class WeightWindowPhysics : public G4VPhysicsConstructor
+{
+  public:
+    WeightWindowPhysics();
+    ~WeightWindowPhysics() override = default;
+
+    void ConstructParticle() override {}
+    void ConstructProcess() override;
+};
+
+}  // namespace B4c
+
+#endif
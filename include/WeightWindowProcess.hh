@@ -0,0 +1,78 @@
+/// \file B4/B4c/include/WeightWindowProcess.hh
+/// \brief Definition of the B4c::WeightWindowProcess class
+
+#ifndef B4cWeightWindowProcess_h
+#define B4cWeightWindowProcess_h 1
+
+#include "PhotonOrigin.hh"
+
+#include "G4ParticleChange.hh"
+#include "G4VProcess.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Region;
+
+namespace B4c
+{
+
+struct WeightWindow;
+
+/// Applies the weight windows of WeightWindowStore at the end of every step
+/// of its particle type:
+///  - below the window, Russian roulette: the track survives with
+///    probability w / w_survival and then carries w_survival;
+///  - above the window, splitting into n = w / w_survival pieces (at most
+///    /B4c/ww/maxSplit) of weight w / n, the copies being added as
+///    secondaries at the same point with the same momentum.
+/// The window is the one of the region and energy the track is in after
+/// the step. Steps that end on a geometry boundary, of the mass world or
+/// of the scoring planes (ScoringParallelWorld), are left alone, so a
+/// track never changes weight or splits on a plane it crosses. Weights reach the scored photons through the track weight,
+/// which CalorimeterSD fills into the spectra.
+///
+/// The process is forced only while the table holds any window, so without
+/// windows it is never invoked.
+
+class WeightWindowProcess : public G4VProcess
+{
+  public:
+    explicit WeightWindowProcess(const G4String& particleName);
+    ~WeightWindowProcess() override = default;
+
+    void StartTracking(G4Track* track) override;
+
+    G4double PostStepGetPhysicalInteractionLength(const G4Track& track, G4double previousStepSize,
+                                                  G4ForceCondition* condition) override;
+    G4VParticleChange* PostStepDoIt(const G4Track& track, const G4Step& step) override;
+
+    G4double AlongStepGetPhysicalInteractionLength(const G4Track&, G4double, G4double, G4double&,
+                                                   G4GPILSelection*) override
+    {
+      return -1.;
+    }
+    G4VParticleChange* AlongStepDoIt(const G4Track&, const G4Step&) override { return nullptr; }
+    G4double AtRestGetPhysicalInteractionLength(const G4Track&, G4ForceCondition*) override
+    {
+      return -1.;
+    }
+    G4VParticleChange* AtRestDoIt(const G4Track&, const G4Step&) override { return nullptr; }
+
+  private:
+    G4ParticleChange fParticleChange;
+    G4String fParticleName;
+    G4bool fActive = false;
+    G4bool fTagOrigin = false;  ///< Photons: copies keep the original's origin
+    PhotonOriginClassifier fOriginClassifier;
+
+    // Windows of the region of the previous step, looked up again only when
+    // the region or the table changes
+    const G4Region* fRegion = nullptr;
+    const std::vector<WeightWindow>* fWindows = nullptr;
+    G4int fVersion = -1;
+};
+
+}  // namespace B4c
+
+#endif
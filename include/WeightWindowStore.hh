@@ -0,0 +1,88 @@
+/// \file B4/B4c/include/WeightWindowStore.hh
+/// \brief Definition of the B4c::WeightWindowStore class
+
+#ifndef B4cWeightWindowStore_h
+#define B4cWeightWindowStore_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class G4UIcommand;
+class G4UIcmdWithADouble;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+class G4UIdirectory;
+
+namespace B4c
+{
+
+/// Lower weight bound for one energy bin: applies below eMax, down to the
+/// eMax of the previous bin of the same particle and region.
+struct WeightWindow
+{
+  G4double eMax;
+  G4double lower;
+};
+
+/// Weight-window table, keyed on particle, region and energy, filled from
+/// macros:
+///
+///   /B4c/ww/window <particle> <region> <Emax> <unit> <lower weight>
+///   /B4c/ww/upperRatio 5      upper bound = 5 x lower
+///   /B4c/ww/maxSplit 10       at most 10 pieces per split
+///   /B4c/ww/clear
+///   /B4c/ww/list
+///
+/// Regions are the layer regions DetectorConstruction creates ("Target",
+/// "Layer1", ...) and "World". Tracks above the last eMax of their bins
+/// are left alone; the survival weight is the middle of the window.
+///
+/// The table is master-only: the commands are not broadcast, the workers
+/// only read it while a run is in progress (see WeightWindowProcess).
+
+class WeightWindowStore : public G4UImessenger
+{
+  public:
+    static WeightWindowStore& Instance();
+
+    /// Energy bins for a particle in a region, or nullptr without windows
+    const std::vector<WeightWindow>* Find(const G4String& particle,
+                                          const G4String& region) const;
+
+    G4bool IsEmpty() const { return fWindows.empty(); }
+    G4int GetVersion() const { return fVersion; }  ///< Changes with every edit
+    G4double GetUpperRatio() const { return fUpperRatio; }
+    G4double GetSurvivalRatio() const { return 0.5 * (1. + fUpperRatio); }
+    G4int GetMaxSplit() const { return fMaxSplit; }
+
+    void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+  private:
+    WeightWindowStore();
+    ~WeightWindowStore() override;
+
+    void AddWindow(const G4String& particle, const G4String& region, G4double eMax,
+                   G4double lower);
+    void List() const;
+
+    std::map<std::pair<G4String, G4String>, std::vector<WeightWindow>> fWindows;
+    G4double fUpperRatio = 5.;
+    G4int fMaxSplit = 10;
+    G4int fVersion = 0;
+
+    std::unique_ptr<G4UIdirectory> fDirectory;
+    std::unique_ptr<G4UIcommand> fWindowCmd;
+    std::unique_ptr<G4UIcmdWithADouble> fUpperRatioCmd;
+    std::unique_ptr<G4UIcmdWithAnInteger> fMaxSplitCmd;
+    std::unique_ptr<G4UIcmdWithoutParameter> fClearCmd;
+    std::unique_ptr<G4UIcmdWithoutParameter> fListCmd;
+};
+
+}  // namespace B4c
+
+#endif
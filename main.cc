@@ -3,53 +3,99 @@
 
 #include "ActionInitialization.hh"
 #include "DetectorConstruction.hh"
+#include "ScoringParallelWorld.hh"
+#include "ScoringWindowPhysics.hh"
+#include "WeightWindowPhysics.hh"
+#include "PhysicsTableCache.hh"
+#include "StartupTimer.hh"
 #include "G4PhysListFactory.hh"
 
+#include "G4MTRunManager.hh"
+#include "G4ParallelWorldPhysics.hh"
 #include "G4RunManagerFactory.hh"
 #include "G4SteppingVerbose.hh"
+#include "G4Threading.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
 #include "G4VisExecutive.hh"
 #include "Randomize.hh"
+#include <algorithm>
+#include <cstdlib>
 #include <ctime>
+#include <memory>
 
 int main(int argc, char** argv)
 {
+    B4c::StartupTimer startupTimer;
+
     G4SteppingVerbose::UseBestUnit(4);
     CLHEP::HepRandom::setTheSeed(std::time(nullptr));
 
-    // GUI mode (no args) → Serial to avoid MT/vis crash on beamOn
-    // Batch mode (-m macro) → MT for full speed
+    // Batch mode (-m macro) → MT on all cores, no vis
+    // Interactive mode (no args) → MT as well; EventAction forwards only a
+    // sample of the events to the vis manager so the workers run at full speed
+    // Interactive mode with -t 1 → serial, as interactive sessions used to run
+    // to avoid a crash of MT + vis on beamOn. That crash has not been
+    // reproduced or analysed since; sub-sampling only makes it less likely
+    // by keeping the vis sub-thread mostly idle. Use -t 1 if it shows up.
     bool batchMode = (argc == 3 && std::string(argv[1]) == "-m");
 
-    G4RunManager* runManager = nullptr;
+    // Leave one core to the GUI and the vis sub-thread
+    G4int nThreads = std::max(1, G4Threading::G4GetNumberOfCores() - 1);
+    if (argc == 3 && std::string(argv[1]) == "-t") nThreads = std::max(1, std::atoi(argv[2]));
+    bool serialGui = !batchMode && nThreads == 1;
+
+    auto runManager = G4RunManagerFactory::CreateRunManager(
+        serialGui ? G4RunManagerType::SerialOnly : G4RunManagerType::MTOnly);
     if (batchMode) {
-        runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::MTOnly);
         static_cast<G4MTRunManager*>(runManager)->SetNumberOfThreads(0); // all cores
         G4cout << "[main] Batch mode: multithreaded" << G4endl;
+    } else if (serialGui) {
+        G4cout << "[main] Interactive mode: serial" << G4endl;
     } else {
-        runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::SerialOnly);
-        G4cout << "[main] GUI mode: serial (MT disabled to prevent vis crash)" << G4endl;
+        static_cast<G4MTRunManager*>(runManager)->SetNumberOfThreads(nThreads);
+        G4cout << "[main] Interactive mode: multithreaded (" << nThreads
+               << " threads, -t 1 for serial), sub-sampled visualization" << G4endl;
     }
 
+    startupTimer.Mark("run manager");
+
     auto detConstruction = new B4c::DetectorConstruction();
     runManager->SetUserInitialization(detConstruction);
 
+    const G4String physicsListName = "FTFP_BERT_LIV";
     G4PhysListFactory factory;
-    auto physicsList = factory.GetReferencePhysList("FTFP_BERT_LIV");
+    auto physicsList = factory.GetReferencePhysList(physicsListName);
+    physicsList->RegisterPhysics(new B4c::ScoringWindowPhysics());
+    physicsList->RegisterPhysics(new B4c::WeightWindowPhysics());
+    physicsList->RegisterPhysics(
+      new G4ParallelWorldPhysics(B4c::ScoringParallelWorld::kWorldName));
     runManager->SetUserInitialization(physicsList);
 
     auto actionInitialization = new B4c::ActionInitialization();
     runManager->SetUserInitialization(actionInitialization);
+    startupTimer.Mark("user initializations");
 
-    auto visManager = new G4VisExecutive;
-    visManager->Initialize();
+    // Batch runs repeat the same few materials and cuts over and over, so the
+    // EM tables are kept in a local cache instead of being rebuilt each time
+    std::unique_ptr<B4c::PhysicsTableCache> tableCache;
+    if (batchMode)
+        tableCache = std::make_unique<B4c::PhysicsTableCache>(physicsList, physicsListName);
+
+    // Visualization is only ever used interactively
+    G4VisManager* visManager = nullptr;
+    if (!batchMode) {
+        visManager = new G4VisExecutive;
+        visManager->Initialize();
+        startupTimer.Mark("visualization manager");
+    }
 
     auto UImanager = G4UImanager::GetUIpointer();
 
     if (!batchMode) {
-        // GUI / interactive mode — serial
+        // GUI / interactive mode; short snapshots for the live spectrum
         auto ui = new G4UIExecutive(argc, argv);
+        UImanager->ApplyCommand("/B4c/run/snapshotInterval 5 s");
         UImanager->ApplyCommand("/control/execute macros/run1.mac");
         UImanager->ApplyCommand("/control/execute macros/init_vis.mac");
         UImanager->ApplyCommand("/control/execute macros/vis.mac");
@@ -85,6 +85,14 @@ def get_energy_mev(arr):
         return arr["KineticEnergy_MeV"].astype(float)
     raise KeyError("Missing energy column")
 
+def get_weights(arr):
+    # Track weights of biased runs (importance sampling, weight windows);
+    # files from before the Weight column are analog, weight 1
+    names = arr.dtype.names or ()
+    if "Weight" in names:
+        return arr["Weight"].astype(float)
+    return np.ones(arr.shape[0])
+
 def get_gamma_mask(arr):
     names = arr.dtype.names or ()
     if "Particle" not in names:
@@ -115,7 +123,7 @@ os.makedirs(output_binned_dir, exist_ok=True)
 
 # =========================================================
 # COLLECT RAW ENERGIES BY MATERIAL & THICKNESS
-# data_by_material[material][thickness] = 1D array of energies in MeV
+# data_by_material[material][thickness] = (energies in MeV, weights)
 # =========================================================
 data_by_material = defaultdict(lambda: defaultdict(list))
 
@@ -141,6 +149,7 @@ for fp in files:
 
     try:
         energies_mev = get_energy_mev(arr)
+        weights_all = get_weights(arr)
         gamma_mask = get_gamma_mask(arr)
     except KeyError as e:
         print(f"Skipping {fp}: {e}")
@@ -151,14 +160,15 @@ for fp in files:
         continue
 
     energies = energies_mev[gamma_mask]
-    energies = energies[np.isfinite(energies)]
-    energies = energies[(energies >= 0.0) & (energies <= max_energy_MeV)]
+    weights = weights_all[gamma_mask]
+    usable = np.isfinite(energies) & (energies >= 0.0) & (energies <= max_energy_MeV)
+    energies, weights = energies[usable], weights[usable]
 
     if energies.size == 0:
         print(f"No usable energies in {fp}")
         continue
 
-    data_by_material[material][thickness].append(energies)
+    data_by_material[material][thickness].append((energies, weights))
     print(f"Loaded {fp}: material={material}, thickness={thickness} mm, count={energies.size}")
 
 # Concatenate per material/thickness
@@ -168,7 +178,8 @@ for material in list(data_by_material.keys()):
         if len(chunks) == 0:
             del data_by_material[material][thickness]
         else:
-            data_by_material[material][thickness] = np.concatenate(chunks)
+            data_by_material[material][thickness] = (
+                np.concatenate([c[0] for c in chunks]), np.concatenate([c[1] for c in chunks]))
 
 # =========================================================
 # BINNING SETUP
@@ -186,24 +197,32 @@ for material, thk_dict in data_by_material.items():
 
     ordered = OrderedDict(sorted(thk_dict.items(), key=lambda kv: float(kv[0])))
 
-    # Bin counts for each thickness
+    # Weighted bin counts and their uncertainty sqrt(sum w^2) for each thickness
     counts_by_thickness = {}
-    for thk, energies_mev in ordered.items():
-        counts, _ = np.histogram(energies_mev, bins=bins)
+    errors_by_thickness = {}
+    for thk, (energies_mev, weights) in ordered.items():
+        counts, _ = np.histogram(energies_mev, bins=bins, weights=weights)
+        sum_w2, _ = np.histogram(energies_mev, bins=bins, weights=weights ** 2)
         counts_by_thickness[thk] = counts
+        errors_by_thickness[thk] = np.sqrt(sum_w2)
 
     # Save binned CSV
     if save_binned_csv:
         csv_path = os.path.join(output_binned_dir, f"binned_{safe_material_name(material)}.csv")
         with open(csv_path, "w", newline="") as f:
             writer = csv.writer(f)
-            header = ["Energy_MeV"] + [f"{material}_{thk}mm" for thk in ordered.keys()]
+            # Each count column is followed by its statistical uncertainty,
+            # sqrt(sum w^2) of the record weights (sqrt(N) for analog runs).
+            header = ["Energy_MeV"]
+            for thk in ordered.keys():
+                header += [f"{material}_{thk}mm", f"{material}_{thk}mm_err"]
             writer.writerow(header)
 
             for i, e in enumerate(bin_centers_mev):
                 row = [f"{e:.6f}"]
                 for thk in ordered.keys():
-                    row.append(int(counts_by_thickness[thk][i]))
+                    row += [f"{counts_by_thickness[thk][i]:.10g}",
+                            f"{errors_by_thickness[thk][i]:.6g}"]
                 writer.writerow(row)
 
         print(f"Saved binned CSV: {csv_path}")
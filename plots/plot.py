@@ -56,11 +56,15 @@ def load_gammas(path):
     arr = np.genfromtxt(path, delimiter=',', names=True, dtype=None, encoding=None, invalid_raise=False)
     if arr.size == 0: return None
     if arr.shape == (): arr = np.array([arr])
-    e = arr['KineticEnergy'][arr['Particle'] == 'gamma'].astype(float)
-    e = e[(e > 0) & (e <= MAX_ENERGY)]
+    gamma = arr['Particle'] == 'gamma'
+    e = arr['KineticEnergy'][gamma].astype(float)
+    # Track weights of biased runs; older files have no Weight column (analog)
+    w = arr['Weight'][gamma].astype(float) if 'Weight' in arr.dtype.names else np.ones(len(e))
+    usable = (e > 0) & (e <= MAX_ENERGY)
+    e, w = e[usable], w[usable]
     print(f"  {os.path.basename(path)}: {len(e):,} gammas, "
           f"E=[{e.min()*1000:.1f}, {e.max()*1000:.0f}] keV")
-    return e
+    return e, w
 
 # ── Discover and group ────────────────────────────────────────────────────────
 pattern = os.path.join(DATA_FOLDER, f"loweroutput_G4_{MATERIAL}_*.txt")
@@ -82,11 +86,11 @@ for fp in all_files:
 thickness_energies = {}
 for t in sorted(groups.keys()):
     print(f"Loading {thickness_label(t)}:")
-    chunks = [e for fp in sorted(groups[t])
-              if (e := load_gammas(fp)) is not None and len(e) > 0]
+    chunks = [ew for fp in sorted(groups[t])
+              if (ew := load_gammas(fp)) is not None and len(ew[0]) > 0]
     if chunks:
-        merged = np.concatenate(chunks)
-        thickness_energies[t] = merged
+        merged = np.concatenate([c[0] for c in chunks])
+        thickness_energies[t] = (merged, np.concatenate([c[1] for c in chunks]))
         print(f"  → total: {len(merged):,} gammas\n")
 
 if not thickness_energies:
@@ -102,8 +106,8 @@ fig, ax = plt.subplots(figsize=(8, 6))
 colors = plt.cm.viridis(np.linspace(0, 1, len(thickness_energies)))
 
 for color, t in zip(colors, sorted(thickness_energies.keys())):
-    e = thickness_energies[t]
-    counts, _ = np.histogram(e, bins=bins)
+    e, w = thickness_energies[t]
+    counts, _ = np.histogram(e, bins=bins, weights=w)
     valid = counts > 0
     ax.plot(bin_left[valid], counts[valid],
             lw=2, color=color, label=thickness_label(t))
@@ -0,0 +1,62 @@
+"""
+plot_live_spectrum.py
+Follows the spectrum snapshot of a running simulation.
+The master rewrites data/spectrum_<material>_<thickness>mm.csv every
+/B4c/run/snapshotInterval (atomically, via rename), so the file can be
+re-read at any time without seeing a partial write.
+"""
+
+import glob
+import os
+import sys
+import time
+
+import numpy as np
+import matplotlib.pyplot as plt
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+DATA_FOLDER   = "data"                # relative to the build directory
+SNAPSHOT_FILE = sys.argv[1] if len(sys.argv) > 1 else None   # None = newest in DATA_FOLDER
+POLL_SECONDS  = 10.0
+MIN_ENERGY    = 0.01                 # MeV, same cut as plot_all_materials.py
+# ──────────────────────────────────────────────────────────────────────────────
+
+plt.ion()
+fig, ax = plt.subplots(figsize=(8, 6))
+last_mtime = None
+
+while plt.fignum_exists(fig.number):
+    if SNAPSHOT_FILE is None:
+        candidates = glob.glob(os.path.join(DATA_FOLDER, "spectrum_*.csv"))
+        if not candidates:
+            plt.pause(POLL_SECONDS)
+            continue
+        SNAPSHOT_FILE = max(candidates, key=os.path.getmtime)
+        print(f"Following {SNAPSHOT_FILE}")
+
+    try:
+        mtime = os.path.getmtime(SNAPSHOT_FILE)
+    except OSError:
+        mtime = None
+
+    if mtime is not None and mtime != last_mtime:
+        last_mtime = mtime
+        data = np.genfromtxt(SNAPSHOT_FILE, delimiter=",", names=True)
+        energy = data["Energy_MeV"]
+        labels = [n for n in data.dtype.names[1:] if not n.endswith("_err")]
+
+        ax.clear()
+        for label in labels:
+            counts = data[label]
+            valid = (counts > 0) & (energy >= MIN_ENERGY)
+            ax.plot(energy[valid], counts[valid], lw=2, label=label)
+        ax.set_xscale("log")
+        ax.set_yscale("log")
+        ax.set_xlabel("Photon Energy [MeV]")
+        ax.set_ylabel("Photon Counts per 2 keV Bin")
+        ax.set_title(f"Live spectrum — {time.strftime('%H:%M:%S', time.localtime(mtime))}")
+        ax.grid(True, which="both", linestyle="--", linewidth=0.5, alpha=0.7)
+        ax.legend(loc="best")
+        fig.canvas.draw_idle()
+
+    plt.pause(POLL_SECONDS)
@@ -0,0 +1,53 @@
+"""
+plot_origins.py
+Decomposition of the scored photon spectrum by creator process, from the
+data/origins_<material>_<thickness>mm.csv file written at the end of a run
+(columns <plane label>_brems, _fluo, _annihil, _other, each with _err).
+
+    python plot_origins.py build/data/origins_G4_W_0.1mm.csv
+"""
+
+import csv
+import sys
+
+import numpy as np
+import matplotlib.pyplot as plt
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+ORIGINS_FILE = sys.argv[1] if len(sys.argv) > 1 else "build/data/origins_G4_W_0.1mm.csv"
+OUTPUT_PNG   = "origins.png"
+MIN_ENERGY   = 0.01                   # MeV, same cut as plot_all_materials.py
+ORIGINS      = ["brems", "fluo", "annihil", "other"]
+# ──────────────────────────────────────────────────────────────────────────────
+
+with open(ORIGINS_FILE, newline="") as f:
+    rows = list(csv.reader(f))
+header, body = rows[0], np.array(rows[1:], dtype=float)
+columns = {name: body[:, i] for i, name in enumerate(header)}
+energy = columns["Energy_MeV"]
+keep = energy >= MIN_ENERGY
+
+# One panel per scoring plane
+planes = [name[: -len("_brems")] for name in header if name.endswith("_brems")]
+fig, axes = plt.subplots(len(planes), 1, figsize=(8, 4.5 * len(planes)), squeeze=False)
+
+for ax, plane in zip(axes[:, 0], planes):
+    total = sum(columns[f"{plane}_{origin}"].sum() for origin in ORIGINS)
+    for origin in ORIGINS:
+        counts = columns[f"{plane}_{origin}"]
+        if counts.sum() <= 0:
+            continue
+        share = 100.0 * counts.sum() / total
+        ax.step(energy[keep], counts[keep], where="mid", lw=1,
+                label=f"{origin} ({share:.1f} %)")
+    ax.set_title(plane)
+    ax.set_xlabel("Photon energy [MeV]")
+    ax.set_ylabel("Weighted counts / 2 keV")
+    ax.set_xscale("log")
+    ax.set_yscale("log")
+    ax.grid(True, which="both", linestyle="--", linewidth=0.5, alpha=0.7)
+    ax.legend()
+
+plt.tight_layout()
+plt.savefig(OUTPUT_PNG, dpi=300, bbox_inches="tight")
+print(f"Saved plot: {OUTPUT_PNG}")
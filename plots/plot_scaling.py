@@ -0,0 +1,41 @@
+"""
+plot_scaling.py
+Speedup and parallel efficiency from the scaling_study CSV table.
+"""
+
+import numpy as np
+import matplotlib.pyplot as plt
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+CSV_FILE   = "build/scaling_study.csv"
+OUTPUT_PNG = "scaling_study.png"
+# ──────────────────────────────────────────────────────────────────────────────
+
+data = np.genfromtxt(CSV_FILE, delimiter=",", names=True)
+threads = np.atleast_1d(data["Threads"])
+
+fig, (ax1, ax2) = plt.subplots(1, 2, figsize=(11, 4.5))
+
+ax1.plot(threads, np.atleast_1d(data["Speedup"]), "o-", lw=2, label="measured")
+ax1.plot(threads, threads, "k--", lw=1, label="ideal")
+ax1.set_xlabel("Worker threads")
+ax1.set_ylabel("Speedup")
+ax1.set_xscale("log", base=2)
+ax1.set_yscale("log", base=2)
+ax1.legend()
+
+ax2.plot(threads, np.atleast_1d(data["Efficiency"]), "o-", lw=2, label="efficiency")
+ax2.plot(threads, 1.0 - np.atleast_1d(data["MeanIdleFraction"]), "s--", lw=1,
+         label="1 - mean idle fraction")
+ax2.set_xlabel("Worker threads")
+ax2.set_ylabel("Fraction")
+ax2.set_xscale("log", base=2)
+ax2.set_ylim(0, 1.05)
+ax2.legend()
+
+for ax in (ax1, ax2):
+    ax.grid(True, which="both", linestyle="--", linewidth=0.5, alpha=0.7)
+
+plt.tight_layout()
+plt.savefig(OUTPUT_PNG, dpi=300, bbox_inches="tight")
+print(f"Saved plot: {OUTPUT_PNG}")
@@ -0,0 +1,140 @@
+"""
+point_detector_check.py
+Next-event estimator against the analog photon flux on a thin target.
+
+Runs a thin foil followed by a vacuum drift layer, so the last scoring
+plane is a 2 x 2 cm square far behind the foil, around 0 degrees. The
+analog fluence there is the weighted plane count divided by its area
+(the photons cross it nearly at normal incidence). The same run puts a
+grid of point detectors (/B4c/ned/detector) on the plane; their mean is
+the estimated fluence averaged over the square. Both are compared per
+energy bin by a chi-square test and by the ratio of their integrals:
+
+    cd build
+    python3 ../plots/point_detector_check.py --exe ./brems_sim_b4c
+
+The bremsstrahlung density of the estimator is taken about the electron
+direction at the emission, so a wrong axis shows up as a ratio away from
+1 in the forward peak. Rayleigh scattering sites do not contribute to the
+estimate (PointDetectorEstimator), hence the lower energy cut. The exit
+status is 1 if the p-value is below --alpha.
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+import numpy as np
+
+from spectrum_regression import MACRO, chi2_sf, read_columns, spectrum_of
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+MATERIAL       = "W"
+THICKNESS_MM   = 0.1
+DRIFT_MM       = 400.0                # vacuum layer between foil and plane
+PLANE_HALF_MM  = 10.0                 # half side of the scoring slabs (2 x 2 cm)
+GRID           = 5                    # point detectors per side of the plane
+EVENTS         = 200000
+ENERGY_MIN     = 0.1                  # MeV, below it Rayleigh scattering matters
+REBIN          = 25                   # spectrum bins merged for the chi-square
+ALPHA          = 1e-3
+WORK_DIR       = "point_detector_check"
+# ──────────────────────────────────────────────────────────────────────────────
+
+
+def grid_points():
+    """Cell centres of a GRID x GRID grid on the plane, in mm."""
+    step = 2.0 * PLANE_HALF_MM / GRID
+    return [-PLANE_HALF_MM + (i + 0.5) * step for i in range(GRID)]
+
+
+def run(exe, events, macro):
+    shutil.rmtree(WORK_DIR, ignore_errors=True)
+    os.makedirs(os.path.join(WORK_DIR, "data"))
+    os.symlink(os.path.abspath("macros"), os.path.join(WORK_DIR, "macros"))
+    with open(os.path.join(WORK_DIR, "geometry.txt"), "w") as f:
+        f.write(f"layer {MATERIAL} {THICKNESS_MM}\nlayer Galactic {DRIFT_MM}\noutput none\n")
+
+    # The foil is centred on the origin, the drift layer starts at its back
+    plane_z = THICKNESS_MM / 2.0 + DRIFT_MM
+    with open(os.path.join(WORK_DIR, "run.mac"), "w") as f:
+        f.write(f"/control/execute {macro}\n")
+        for x in grid_points():
+            for y in grid_points():
+                f.write(f"/B4c/ned/detector {x:g} {y:g} {plane_z:g} mm\n")
+        f.write(f"/run/beamOn {events}\n")
+
+    proc = subprocess.run([os.path.abspath(exe), "-m", "run.mac"], cwd=WORK_DIR,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    with open(os.path.join(WORK_DIR, "run.log"), "w") as f:
+        f.write(proc.stdout)
+    if proc.returncode != 0:
+        sys.exit(f"[point_detector_check] exit status {proc.returncode}, see {WORK_DIR}/run.log")
+
+    def one_file(pattern):
+        files = glob.glob(os.path.join(WORK_DIR, "data", pattern))
+        if len(files) != 1:
+            sys.exit(f"[point_detector_check] expected one {pattern}, found {files}")
+        return read_columns(files[0])
+
+    return one_file("spectrum_*.csv"), one_file("pointdet_*.csv")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--exe", default="./brems_sim_b4c")
+    parser.add_argument("--events", type=int, default=EVENTS)
+    parser.add_argument("--macro", default=MACRO)
+    parser.add_argument("--alpha", type=float, default=ALPHA)
+    args = parser.parse_args()
+
+    print(f"[point_detector_check] {MATERIAL} {THICKNESS_MM} mm + {DRIFT_MM:g} mm vacuum, "
+          f"{GRID}x{GRID} point detectors ({args.events} events)", flush=True)
+    planes, points = run(args.exe, args.events, args.macro)
+
+    # Analog: the last plane (behind the drift layer), per cm^2
+    area_cm2 = (2.0 * PLANE_HALF_MM / 10.0) ** 2
+    plane_label = [name for name in planes if name != "Energy_MeV"
+                   and not name.endswith("_err")][-1]
+    analog, analog_err = (v / area_cm2 for v in spectrum_of(planes, plane_label))
+
+    # Estimate: mean of the grid; the detectors see the same emissions, so
+    # their errors are added as fully correlated
+    labels = [name for name in points if name.startswith("pd") and not name.endswith("_err")]
+    estimate = np.mean([points[label] for label in labels], axis=0)
+    estimate_err = np.mean([spectrum_of(points, label)[1] for label in labels], axis=0)
+
+    energy = planes["Energy_MeV"]
+    keep = energy >= ENERGY_MIN
+    n = keep.sum() // REBIN * REBIN
+
+    def rebin(values, squared=False):
+        v = values[keep][:n].reshape(-1, REBIN)
+        return np.sqrt(np.sum(v ** 2, axis=1)) if squared else v.sum(axis=1)
+
+    a, ea, b, eb = rebin(analog), rebin(analog_err, True), rebin(estimate), rebin(estimate_err, True)
+    used = (ea > 0) & (eb > 0)
+    chi2 = float(np.sum((a[used] - b[used]) ** 2 / (ea[used] ** 2 + eb[used] ** 2)))
+    ndf = int(used.sum())
+    p = chi2_sf(chi2, ndf)
+
+    total_a, total_b = analog[keep].sum(), estimate[keep].sum()
+    ratio = total_b / total_a if total_a > 0 else float("nan")
+    ratio_err = ratio * np.sqrt(np.sum(analog_err[keep] ** 2) / total_a ** 2
+                                + np.sum(estimate_err[keep] ** 2) / total_b ** 2)
+
+    print()
+    print(f"analog fluence above {ENERGY_MIN} MeV   {total_a:.5g} cm^-2 ({plane_label})")
+    print(f"point-detector fluence           {total_b:.5g} cm^-2 (mean of {len(labels)})")
+    print(f"ratio estimate / analog          {ratio:.4f} +- {ratio_err:.4f}")
+    print(f"chi2/ndf                         {chi2:.1f}/{ndf}, p = {p:.3g}")
+    ok = p >= args.alpha
+    print(f"[point_detector_check] {'PASS' if ok else 'FAIL'}")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,135 @@
+"""
+read_hits.py
+Reader for the block-compressed per-photon records (.b4h) written by
+CalorimeterSD when geometry.txt contains "output compressed".
+Blocks are independent, so they are decoded in parallel in worker
+processes (the varint decode is a Python loop, so threads would be
+serialized by the GIL). Files from builds without zstd or LZ4 hold
+uncompressed blocks (codec 0). Version 3 files carry the track weight of
+every record; older files read with weight 1. Spectra from biased runs
+(importance sampling, weight windows) must be filled with these weights.
+
+    from read_hits import read_hits
+    cols = read_hits("build/data/loweroutput_G4_W_0.1mm_t0.b4h")
+    counts, edges = np.histogram(cols["KineticEnergy"], bins=500, weights=cols["Weight"])
+
+As a script it converts a .b4h file back to the CSV layout:
+
+    python read_hits.py in.b4h > out.txt
+"""
+
+import struct
+import sys
+from concurrent.futures import ProcessPoolExecutor
+
+import numpy as np
+
+CODEC_NONE = 0
+CODEC_ZSTD = 1
+CODEC_LZ4 = 2
+
+
+def _decompress(codec, payload, raw_size):
+    if codec == CODEC_NONE:
+        return payload
+    if codec == CODEC_ZSTD:
+        import zstandard
+        return zstandard.ZstdDecompressor().decompress(payload, max_output_size=raw_size)
+    if codec == CODEC_LZ4:
+        import lz4.block
+        return lz4.block.decompress(payload, uncompressed_size=raw_size)
+    raise ValueError(f"Unknown codec {codec}")
+
+
+def _unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def _decode_block(version, codec, n_records, raw_size, first_event, payload):
+    raw = _decompress(codec, payload, raw_size)
+    event = np.empty(n_records, dtype=np.int64)
+    track = np.empty(n_records, dtype=np.int64)
+    parent = np.empty(n_records, dtype=np.int64)
+    energy = np.empty(n_records, dtype=np.float32)
+    weight = np.ones(n_records, dtype=np.float32)
+    detector = np.empty(n_records, dtype=np.int64)
+
+    pos = 0
+    last_event = first_event
+
+    def varint():
+        nonlocal pos
+        value, shift = 0, 0
+        while True:
+            b = raw[pos]
+            pos += 1
+            value |= (b & 0x7F) << shift
+            if b < 0x80:
+                return value
+            shift += 7
+
+    for i in range(n_records):
+        last_event += _unzigzag(varint())
+        event[i] = last_event
+        track[i] = _unzigzag(varint())
+        parent[i] = track[i] - _unzigzag(varint())
+        detector[i] = _unzigzag(varint()) if version >= 2 else 0
+        energy[i] = struct.unpack_from("<f", raw, pos)[0]
+        pos += 4
+        if version >= 3:
+            weight[i] = struct.unpack_from("<f", raw, pos)[0]
+            pos += 4
+
+    return event, track, parent, energy, detector, weight
+
+
+def read_hits(path, workers=None):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, codec, header_len = struct.unpack_from("<4sIII", data, 0)
+    if magic != b"B4CH":
+        raise ValueError(f"{path} is not a .b4h file")
+    pos = 16
+    header = data[pos:pos + header_len].decode()
+    pos += header_len
+
+    blocks = []
+    while pos < len(data):
+        tag, n_records, raw_size, comp_size, first_event = struct.unpack_from("<4sIIIi", data, pos)
+        if tag != b"BLK1":
+            raise ValueError(f"Corrupt block at offset {pos} in {path}")
+        pos += 20
+        blocks.append((version, codec, n_records, raw_size, first_event, data[pos:pos + comp_size]))
+        pos += comp_size
+
+    if len(blocks) > 1 and workers != 1:
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            decoded = list(pool.map(_decode_block, *zip(*blocks)))
+    else:
+        decoded = [_decode_block(*b) for b in blocks]
+
+    constants = dict(line.split("=", 1) for line in header.splitlines()[1:] if "=" in line)
+    if not decoded:
+        empty = np.array([], dtype=np.int64)
+        return {"EventID": empty, "TrackID": empty, "ParentID": empty,
+                "KineticEnergy": np.array([], dtype=np.float32), "DetectorID": empty,
+                "Weight": np.array([], dtype=np.float32), **constants}
+    return {
+        "EventID": np.concatenate([d[0] for d in decoded]),
+        "TrackID": np.concatenate([d[1] for d in decoded]),
+        "ParentID": np.concatenate([d[2] for d in decoded]),
+        "KineticEnergy": np.concatenate([d[3] for d in decoded]),
+        "DetectorID": np.concatenate([d[4] for d in decoded]),
+        "Weight": np.concatenate([d[5] for d in decoded]),
+        **constants,
+    }
+
+
+if __name__ == "__main__":
+    cols = read_hits(sys.argv[1])
+    out = sys.stdout
+    out.write("EventID,TrackID,ParentID,Particle,KineticEnergy,Volume,DetectorID,Weight\n")
+    for e, t, p, k, d, w in zip(cols["EventID"], cols["TrackID"], cols["ParentID"],
+                                cols["KineticEnergy"], cols["DetectorID"], cols["Weight"]):
+        out.write(f"{e},{t},{p},{cols['Particle']},{k:g},{cols['Volume']},{d},{w:g}\n")
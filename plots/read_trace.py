@@ -0,0 +1,138 @@
+"""
+read_trace.py
+Reader for the event step traces (.b4t) written by EventTracer, one file
+per worker thread (/B4c/trace/sampleEvery, /B4c/trace/trigger).
+
+Each file holds the ring buffer of one thread: the last traced events,
+oldest first. An event partly overwritten by the ring is dropped.
+
+    from read_trace import read_trace
+    trace = read_trace("build/data/trace_t0.b4t")
+    for steps in trace.events():
+        print(steps["EventID"][0], len(steps))
+
+As a script it prints the steps like /tracking/verbose, or as CSV:
+
+    python read_trace.py data/trace_t*.b4t                 all events
+    python read_trace.py data/trace_t*.b4t --event 4711    one event
+    python read_trace.py data/trace_t*.b4t --triggered --csv > steps.csv
+"""
+
+import argparse
+import struct
+import sys
+
+import numpy as np
+
+EVENT_START, SAMPLED, TRIGGERED, TRUNCATED = 1, 2, 4, 8
+
+# Layout of B4c::TraceRecord (56 bytes, little-endian on all our machines)
+RECORD = np.dtype([
+    ("EventID", "<i4"), ("TrackID", "<i4"), ("ParentID", "<i4"), ("Step", "<i4"),
+    ("Particle", "<u2"), ("Volume", "<u2"), ("Process", "<u2"), ("CopyNo", "<i2"),
+    ("Flags", "<u4"),
+    ("PreEnergy", "<f4"), ("PostEnergy", "<f4"), ("Edep", "<f4"),
+    ("X", "<f4"), ("Y", "<f4"), ("Z", "<f4"), ("Weight", "<f4"),
+])
+
+
+class Trace:
+    """Steps of one thread and the particle, volume and process names."""
+
+    def __init__(self, thread, records, particles, volumes, processes):
+        self.thread = thread
+        self.records = records
+        self.particles, self.volumes, self.processes = particles, volumes, processes
+
+    def events(self):
+        """Records of every complete event, in buffer order."""
+        starts = np.flatnonzero(self.records["Flags"] & EVENT_START)
+        ends = np.append(starts[1:], len(self.records))
+        for begin, end in zip(starts, ends):
+            yield self.records[begin:end]
+
+
+def _read_table(data, pos):
+    (count,) = struct.unpack_from("<I", data, pos)
+    pos += 4
+    names = []
+    for _ in range(count):
+        (length,) = struct.unpack_from("<H", data, pos)
+        pos += 2
+        names.append(data[pos:pos + length].decode())
+        pos += length
+    return names, pos
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, thread, record_size, n_records = struct.unpack_from("<4sIiIQ", data, 0)
+    if magic != b"B4TR":
+        raise ValueError(f"{path} is not a .b4t file")
+    if version != 1 or record_size != RECORD.itemsize:
+        raise ValueError(f"{path}: unsupported version {version} or record size {record_size}")
+    pos = 24
+    particles, pos = _read_table(data, pos)
+    volumes, pos = _read_table(data, pos)
+    processes, pos = _read_table(data, pos)
+    records = np.frombuffer(data, dtype=RECORD, count=n_records, offset=pos)
+    return Trace(thread, records, particles, volumes, processes)
+
+
+def _print_event(trace, steps, out):
+    flags = steps["Flags"][0]
+    why = [name for bit, name in ((SAMPLED, "sampled"), (TRIGGERED, "triggered"),
+                                  (TRUNCATED, "truncated")) if flags & bit]
+    out.write(f"* Event {steps['EventID'][0]} (thread {trace.thread}, {len(steps)} steps, "
+              f"{', '.join(why)})\n")
+    track = None
+    for s in steps:
+        if s["TrackID"] != track:
+            track = s["TrackID"]
+            out.write(f"  Track {track} ({trace.particles[s['Particle']]}), parent "
+                      f"{s['ParentID']}, weight {s['Weight']:g}\n")
+            out.write(f"  {'Step':>5}{'X(mm)':>10}{'Y(mm)':>10}{'Z(mm)':>10}"
+                      f"{'KinE(MeV)':>12}{'dE(MeV)':>11}{'Edep(MeV)':>11}  Volume  Process\n")
+        out.write(f"  {s['Step']:>5}{s['X']:>10.4g}{s['Y']:>10.4g}{s['Z']:>10.4g}"
+                  f"{s['PostEnergy']:>12.5g}{s['PreEnergy'] - s['PostEnergy']:>11.4g}"
+                  f"{s['Edep']:>11.4g}  {trace.volumes[s['Volume']]}[{s['CopyNo']}]"
+                  f"  {trace.processes[s['Process']]}\n")
+
+
+def _write_csv(trace, steps, out):
+    for s in steps:
+        out.write(f"{trace.thread},{s['EventID']},{s['TrackID']},{s['ParentID']},{s['Step']},"
+                  f"{trace.particles[s['Particle']]},{trace.volumes[s['Volume']]},{s['CopyNo']},"
+                  f"{trace.processes[s['Process']]},{s['PreEnergy']:g},{s['PostEnergy']:g},"
+                  f"{s['Edep']:g},{s['X']:g},{s['Y']:g},{s['Z']:g},{s['Weight']:g}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("files", nargs="+", help=".b4t files")
+    parser.add_argument("--event", type=int, help="only this event ID")
+    parser.add_argument("--triggered", action="store_true", help="only triggered events")
+    parser.add_argument("--csv", action="store_true", help="one CSV line per step")
+    args = parser.parse_args()
+
+    out = sys.stdout
+    if args.csv:
+        out.write("Thread,EventID,TrackID,ParentID,Step,Particle,Volume,CopyNo,Process,"
+                  "PreEnergy_MeV,PostEnergy_MeV,Edep_MeV,X_mm,Y_mm,Z_mm,Weight\n")
+    for path in args.files:
+        trace = read_trace(path)
+        for steps in trace.events():
+            if args.event is not None and steps["EventID"][0] != args.event:
+                continue
+            if args.triggered and not steps["Flags"][0] & TRIGGERED:
+                continue
+            if args.csv:
+                _write_csv(trace, steps, out)
+            else:
+                _print_event(trace, steps, out)
+
+
+if __name__ == "__main__":
+    main()
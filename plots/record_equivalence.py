@@ -0,0 +1,121 @@
+"""
+record_equivalence.py
+Exact comparison of the scored photon records of two builds.
+
+Runs the same fixed-seed configurations (macros/regression.mac) with a
+reference and a candidate executable and requires the per-photon records
+(EventID,TrackID,ParentID,Particle,KineticEnergy) to be identical, as a
+multiset, not just statistically compatible. Use it for changes that must
+not change a single scored photon, e.g. the per-track scoring flag that
+replaced the std::set of logged track IDs in CalorimeterSD:
+
+    cd build
+    python3 ../plots/record_equivalence.py --before ../build_7f51875/brems_sim_b4c \\
+        --after ./brems_sim_b4c --results ../binned_data/equivalence_user-027.csv
+
+Event seeds are drawn from the master engine, so the records do not
+depend on the number or scheduling of worker threads; only their order in
+the per-thread files does, and the records are sorted before comparing.
+Both builds write the per-photon CSV records (geometry.txt "output csv",
+the default, and the only output of older builds). The exit status is 1
+if any configuration differs.
+"""
+
+import argparse
+import csv
+import glob
+import os
+import shutil
+import subprocess
+import sys
+from collections import Counter
+
+from spectrum_regression import MACRO, label_of
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+CONFIGS        = ["W:0.1", "W:1.0"]   # material:thickness_mm
+EVENTS         = 50000
+WORK_DIR       = "equivalence"
+KEY_COLUMNS    = ["EventID", "TrackID", "ParentID", "Particle", "KineticEnergy"]
+SHOW_DIFFS     = 10                   # differing records printed per configuration
+# ──────────────────────────────────────────────────────────────────────────────
+
+
+def run_records(exe, material, thickness, events, macro, run_dir):
+    """Runs one configuration; returns a Counter of record tuples."""
+    shutil.rmtree(run_dir, ignore_errors=True)
+    os.makedirs(os.path.join(run_dir, "data"))
+    os.symlink(os.path.abspath("macros"), os.path.join(run_dir, "macros"))
+    with open(os.path.join(run_dir, "geometry.txt"), "w") as f:
+        f.write(f"material {material}\nthickness {thickness}\noutput csv\n")
+    with open(os.path.join(run_dir, "run.mac"), "w") as f:
+        f.write(f"/control/execute {macro}\n/run/beamOn {events}\n")
+
+    proc = subprocess.run([os.path.abspath(exe), "-m", "run.mac"], cwd=run_dir,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    with open(os.path.join(run_dir, "run.log"), "w") as f:
+        f.write(proc.stdout)
+    if proc.returncode != 0:
+        sys.exit(f"[record_equivalence] {exe}: exit status {proc.returncode}, "
+                 f"see {run_dir}/run.log")
+
+    files = glob.glob(os.path.join(run_dir, "data", "loweroutput_*.txt"))
+    if not files:
+        sys.exit(f"[record_equivalence] {exe}: no record files in {run_dir}/data")
+    records = Counter()
+    for path in files:
+        with open(path, newline="") as f:
+            for row in csv.DictReader(f):
+                records[tuple(row[name] for name in KEY_COLUMNS)] += 1
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--before", required=True, help="reference executable")
+    parser.add_argument("--after", required=True, help="candidate executable")
+    parser.add_argument("--configs", nargs="+", default=CONFIGS,
+                        help="material:thickness_mm, e.g. W:0.1")
+    parser.add_argument("--events", type=int, default=EVENTS)
+    parser.add_argument("--macro", default=MACRO)
+    parser.add_argument("--results", help="CSV file for the per-configuration counts")
+    args = parser.parse_args()
+
+    rows = []
+    failed = False
+    for config in args.configs:
+        material, thickness = config.split(":")
+        label = label_of(material, thickness)
+        print(f"[record_equivalence] Running {label} ({args.events} events)", flush=True)
+        before = run_records(args.before, material, thickness, args.events, args.macro,
+                             os.path.join(WORK_DIR, f"{label}_before"))
+        after = run_records(args.after, material, thickness, args.events, args.macro,
+                            os.path.join(WORK_DIR, f"{label}_after"))
+
+        only_before, only_after = before - after, after - before
+        identical = not only_before and not only_after
+        failed |= not identical
+        rows.append([label, args.events, sum(before.values()), sum(after.values()),
+                     sum(only_before.values()), sum(only_after.values()),
+                     "yes" if identical else "no"])
+        for name, diff in (("only before", only_before), ("only after", only_after)):
+            for record in sorted(diff)[:SHOW_DIFFS]:
+                print(f"  {label} {name}: {','.join(record)}")
+
+    print()
+    header = ["Config", "Events", "BeforeRecords", "AfterRecords", "OnlyBefore", "OnlyAfter",
+              "Identical"]
+    print(f"{header[0]:<12}" + "".join(f"{h:>14}" for h in header[1:]))
+    for row in rows:
+        print(f"{row[0]:<12}" + "".join(f"{v:>14}" for v in row[1:]))
+    if args.results:
+        with open(args.results, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(header)
+            writer.writerows(rows)
+        print(f"[record_equivalence] Results written to {args.results}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+"""
+scoring_benchmark.py
+Steps per event, events/s and spectra of two builds of the scoring geometry.
+
+Compares a build before and after a change of the scoring geometry, e.g.
+the 1 um vacuum planes in the mass world against the zero-thickness
+planes of ScoringParallelWorld. For every configuration each build runs
+
+  1. the fixed-seed regression workload (macros/regression.mac) for the
+     events/s and the spectrum, and
+  2. the same workload with the step profiler (macros/step_count.mac) for
+     the steps per event, by particle and volume.
+
+The spectra of the two builds are compared with the chi-square and KS
+tests of spectrum_regression.py; the exit status is 1 if they differ.
+The seeds are the same, but a different geometry draws different random
+numbers, so the spectra agree statistically, not photon by photon.
+Both builds need the /B4c/profile/ commands. --results keeps the numbers
+in a CSV file, to be committed next to the change they measure:
+
+    cd build
+    python3 ../plots/scoring_benchmark.py --before ../build_old/brems_sim_b4c \\
+        --after ./brems_sim_b4c --results ../binned_data/scoring_benchmark.csv
+"""
+
+import argparse
+import csv
+import os
+import sys
+from collections import defaultdict
+
+from spectrum_regression import ALPHA, CONFIGS, MACRO, compare, label_of, run_config
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+EVENTS         = 200000               # events of the timed runs
+PROFILE_EVENTS = 20000                # events of the step-counting runs
+PROFILE_MACRO  = "macros/step_count.mac"
+WORK_DIR       = "scoring_benchmark"
+# ──────────────────────────────────────────────────────────────────────────────
+
+
+def read_step_profile(run_dir):
+    """Steps by particle and by volume from data/step_profile.csv."""
+    by_particle, by_volume = defaultdict(int), defaultdict(int)
+    with open(os.path.join(run_dir, "data", "step_profile.csv"), newline="") as f:
+        for row in csv.DictReader(f):
+            by_particle[row["Particle"]] += int(row["Steps"])
+            by_volume[row["Volume"]] += int(row["Steps"])
+    return by_particle, by_volume
+
+
+def benchmark(exe, material, thickness, args, tag):
+    label = label_of(material, thickness)
+    run_dir = os.path.join(WORK_DIR, f"{tag}_{label}")
+    energy, counts, errors, rate = run_config(exe, material, thickness, args.events,
+                                              args.macro, run_dir=run_dir)
+    run_config(exe, material, thickness, args.profile_events, PROFILE_MACRO,
+               run_dir=run_dir + "_steps")
+    by_particle, by_volume = read_step_profile(run_dir + "_steps")
+    return dict(energy=energy, counts=counts, errors=errors, rate=rate,
+                by_particle=by_particle, by_volume=by_volume)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--before", required=True, help="executable before the change")
+    parser.add_argument("--after", default="./brems_sim_b4c", help="executable after the change")
+    parser.add_argument("--configs", nargs="+", default=CONFIGS,
+                        help="material:thickness_mm, e.g. W:0.1")
+    parser.add_argument("--events", type=int, default=EVENTS)
+    parser.add_argument("--profile-events", type=int, default=PROFILE_EVENTS)
+    parser.add_argument("--macro", default=MACRO)
+    parser.add_argument("--alpha", type=float, default=ALPHA)
+    parser.add_argument("--results", help="CSV file for the numbers of every configuration")
+    args = parser.parse_args()
+
+    rows = []
+    failed = False
+    for config in args.configs:
+        material, thickness = config.split(":")
+        label = label_of(material, thickness)
+        results = {}
+        for tag, exe in (("before", args.before), ("after", args.after)):
+            print(f"[scoring_benchmark] {label}: {tag} ({exe})", flush=True)
+            results[tag] = benchmark(exe, material, thickness, args, tag)
+        before, after = results["before"], results["after"]
+
+        n = args.profile_events
+        print()
+        print(f"{label:<24}{'before':>12}{'after':>12}{'ratio':>8}")
+        steps = [sum(r["by_particle"].values()) / n for r in (before, after)]
+        print(f"{'steps/event':<24}{steps[0]:>12.2f}{steps[1]:>12.2f}{steps[1] / steps[0]:>8.3f}")
+        for name in sorted(set(before["by_particle"]) | set(after["by_particle"])):
+            b, a = (r["by_particle"].get(name, 0) / n for r in (before, after))
+            print(f"{'  ' + name:<24}{b:>12.2f}{a:>12.2f}")
+        for name in sorted(set(before["by_volume"]) | set(after["by_volume"])):
+            b, a = (r["by_volume"].get(name, 0) / n for r in (before, after))
+            print(f"{'  in ' + name:<24}{b:>12.2f}{a:>12.2f}")
+        rates = before["rate"], after["rate"]
+        print(f"{'events/s':<24}{rates[0]:>12.1f}{rates[1]:>12.1f}{rates[1] / rates[0]:>8.3f}")
+
+        r = compare(before["counts"], before["errors"], after["counts"], after["errors"],
+                    args.events, args.events)
+        ok = r["p_chi2"] >= args.alpha and r["p_ks"] >= args.alpha
+        failed |= not ok
+        print(f"{'spectrum':<24}chi2/ndf {r['chi2']:.1f}/{r['ndf']}, p = {r['p_chi2']:.3g}; "
+              f"KS D = {r['ks']:.4f}, p = {r['p_ks']:.3g}  {'PASS' if ok else 'FAIL'}")
+        print()
+        rows.append([label, f"{steps[0]:.4g}", f"{steps[1]:.4g}", f"{rates[0]:.6g}",
+                     f"{rates[1]:.6g}", f"{r['chi2']:.4g}", r["ndf"], f"{r['p_chi2']:.3g}",
+                     f"{r['ks']:.4g}", f"{r['p_ks']:.3g}", "PASS" if ok else "FAIL"])
+
+    if args.results:
+        with open(args.results, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["Config", "StepsPerEventBefore", "StepsPerEventAfter",
+                             "EventsPerSecondBefore", "EventsPerSecondAfter", "Chi2", "Ndf",
+                             "PChi2", "KS", "PKS", "Spectrum"])
+            writer.writerows(rows)
+        print(f"[scoring_benchmark] Results written to {args.results}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,369 @@
+"""
+spectrum_regression.py
+Statistical regression check of the photon spectrum between builds.
+
+Runs fixed-seed reference configurations (macros/regression.mac, primary
+spectrum from macros/spectrum_new.mac), compares every spectrum with the
+stored reference in the binned_W.csv layout and reports the throughput
+next to the reference throughput:
+
+    cd build
+    python3 ../plots/spectrum_regression.py --exe ./brems_sim_b4c
+
+    # accept the current build as the new reference
+    python3 ../plots/spectrum_regression.py --exe ./brems_sim_b4c --update-reference
+
+    # a variance-reduction setup must reproduce the analog reference
+    python3 ../plots/spectrum_regression.py --exe ./brems_sim_b4c --macro macros/tail_bias.mac
+
+Each configuration is compared with
+  - a chi-square test over the bins, using the per-bin uncertainties
+    (the "_err" columns; sqrt(N) where a file has none), and
+  - a two-sample Kolmogorov-Smirnov test on the cumulative spectra, with
+    the effective number of entries sum(w)^2 / sum(w^2).
+The exit status is 1 if any p-value is below --alpha. For variance
+reduction the report also gives the figure of merit 1 / (relative
+error^2 x CPU time) of the spectrum above --tail-energy, relative to the
+reference run.
+
+Reference files, written by --update-reference (make regression_reference)
+with the fixed seeds of macros/regression.mac:
+  binned_data/reference_W.csv       Energy_MeV,<label>,<label>_err,...
+  binned_data/reference_W_meta.csv  Label,Events,EventsPerSecond,Geant4Version
+The reference is only valid for the Geant4 version it was made with;
+--geant4-version (passed by CMake) is stored with it, and a check against
+a different version is reported next to the result.
+Both are required: without them the check fails instead of comparing with
+anything else, unless --skip-missing is given (make regression on a tree
+without a stored reference), which reports the check as skipped and
+exits 0 without running anything. --shape-only accepts a reference without a meta file (e.g.
+binned_W.csv from plot_all_materials.py); both spectra are then
+normalized to unit area and only the shapes are compared.
+"""
+
+import argparse
+import csv
+import glob
+import math
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+REFERENCE_CSV  = "../binned_data/reference_W.csv"
+CONFIGS        = ["W:0.1", "W:1.0"]   # material:thickness_mm
+EVENTS         = 200000
+MACRO          = "macros/regression.mac"
+WORK_DIR       = "regression"
+ALPHA          = 1e-3                 # p-value below which a test fails
+MIN_BIN_COUNT  = 10.0                 # bins with fewer entries are merged
+TAIL_ENERGY    = 5.0                  # MeV, lower edge of the figure-of-merit tail
+# ──────────────────────────────────────────────────────────────────────────────
+
+
+def label_of(material, thickness):
+    return f"{material}_{thickness}mm"
+
+
+def meta_file_of(reference_csv):
+    root, ext = os.path.splitext(reference_csv)
+    return f"{root}_meta{ext}"
+
+
+def read_columns(path):
+    """Column name -> numpy array; names are kept as written (no mangling)."""
+    with open(path, newline="") as f:
+        rows = list(csv.reader(f))
+    header, body = rows[0], np.array(rows[1:], dtype=float)
+    return {name: body[:, i] for i, name in enumerate(header)}
+
+
+def read_meta(path):
+    """Label -> (events, events/s), and the Geant4 versions of the reference."""
+    meta, versions = {}, set()
+    if os.path.exists(path):
+        with open(path, newline="") as f:
+            for row in csv.DictReader(f):
+                meta[row["Label"]] = (float(row["Events"]), float(row["EventsPerSecond"]))
+                if row.get("Geant4Version"):
+                    versions.add(row["Geant4Version"])
+    return meta, versions
+
+
+def spectrum_of(columns, label):
+    """(counts, errors) of one label; sqrt(N) when there is no _err column."""
+    counts = columns[label]
+    errors = columns.get(f"{label}_err", np.sqrt(np.abs(counts)))
+    return counts, errors
+
+
+# ── STATISTICS ────────────────────────────────────────────────────────────────
+def chi2_sf(chi2, ndf):
+    """Upper tail of the chi-square distribution (regularized gamma Q)."""
+    if ndf <= 0:
+        return 1.0
+    a, x = 0.5 * ndf, 0.5 * chi2
+    if x <= 0.0:
+        return 1.0
+    if x < a + 1.0:
+        # series for P(a, x)
+        term = total = 1.0 / a
+        n = a
+        for _ in range(1000):
+            n += 1.0
+            term *= x / n
+            total += term
+            if abs(term) < abs(total) * 1e-15:
+                break
+        return max(0.0, 1.0 - total * math.exp(-x + a * math.log(x) - math.lgamma(a)))
+    # continued fraction for Q(a, x)
+    b = x + 1.0 - a
+    c = 1.0 / 1e-300
+    d = 1.0 / b
+    h = d
+    for i in range(1, 1000):
+        an = -i * (i - a)
+        b += 2.0
+        d = an * d + b
+        d = 1e-300 if abs(d) < 1e-300 else d
+        c = b + an / c
+        c = 1e-300 if abs(c) < 1e-300 else c
+        d = 1.0 / d
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-15:
+            break
+    return math.exp(-x + a * math.log(x) - math.lgamma(a)) * h
+
+
+def ks_sf(d, n_eff):
+    """Asymptotic Kolmogorov distribution with Stephens' small-n correction."""
+    if n_eff <= 0:
+        return 1.0
+    sn = math.sqrt(n_eff)
+    lam = (sn + 0.12 + 0.11 / sn) * d
+    if lam < 1e-3:
+        return 1.0
+    p = 2.0 * sum((-1) ** (k - 1) * math.exp(-2.0 * k * k * lam * lam) for k in range(1, 101))
+    return min(1.0, max(0.0, p))
+
+
+def merge_sparse_bins(a, va, b, vb, min_count):
+    """Merges adjacent bins until they hold min_count entries per spectrum on average.
+
+    The rule only looks at the sum of both spectra, so it does not select
+    bins by how well they agree.
+    """
+    out_a, out_va, out_b, out_vb = [], [], [], []
+    sa = sva = sb = svb = 0.0
+    for x, vx, y, vy in zip(a, va, b, vb):
+        sa, sva, sb, svb = sa + x, sva + vx, sb + y, svb + vy
+        if sa + sb >= 2.0 * min_count:
+            out_a.append(sa); out_va.append(sva); out_b.append(sb); out_vb.append(svb)
+            sa = sva = sb = svb = 0.0
+    if out_a and (sa > 0.0 or sb > 0.0):
+        # leftover tail goes into the last full bin
+        out_a[-1] += sa; out_va[-1] += sva; out_b[-1] += sb; out_vb[-1] += svb
+    return map(np.array, (out_a, out_va, out_b, out_vb))
+
+
+def compare(ref, ref_err, new, new_err, ref_events=None, new_events=None):
+    """Chi-square and KS comparison of two binned spectra.
+
+    With both event counts the spectra are compared per primary; without,
+    both are normalized to unit area (shape only, one degree of freedom less).
+    """
+    a, va, b, vb = merge_sparse_bins(ref, ref_err ** 2, new, new_err ** 2, MIN_BIN_COUNT)
+    if a.size == 0:
+        return dict(chi2=float("nan"), ndf=0, p_chi2=1.0, ks=float("nan"), p_ks=1.0)
+
+    if ref_events and new_events:
+        na, nb, ndf = ref_events, new_events, a.size
+    else:
+        na, nb, ndf = a.sum(), b.sum(), a.size - 1
+    # Pooled variance under the null hypothesis: both spectra share the rate
+    # (a + b) / (na + nb) and the mean weight (va + vb) / (a + b) of a bin
+    diff = a / na - b / nb
+    var = (va + vb) / (na + nb) * (1.0 / na + 1.0 / nb)
+    chi2 = float(np.sum(diff ** 2 / var))
+
+    cdf_a = np.cumsum(ref) / ref.sum()
+    cdf_b = np.cumsum(new) / new.sum()
+    d = float(np.max(np.abs(cdf_a - cdf_b)))
+    neff_a = ref.sum() ** 2 / np.sum(ref_err ** 2)
+    neff_b = new.sum() ** 2 / np.sum(new_err ** 2)
+    n_eff = neff_a * neff_b / (neff_a + neff_b)
+
+    return dict(chi2=chi2, ndf=ndf, p_chi2=chi2_sf(chi2, ndf), ks=d, p_ks=ks_sf(d, n_eff))
+
+
+def tail_fom(energy, counts, errors, events, rate, tail_energy):
+    """Figure of merit 1 / (rel. error^2 x time) of the integral above tail_energy."""
+    tail = energy >= tail_energy
+    total, variance = counts[tail].sum(), np.sum(errors[tail] ** 2)
+    if total <= 0.0 or variance <= 0.0 or not rate > 0.0:
+        return float("nan")
+    return total ** 2 / variance / (events / rate)
+
+
+# ── RUNNING THE CONFIGURATIONS ────────────────────────────────────────────────
+def run_config(exe, material, thickness, events, macro=MACRO, seeds=None, run_dir=None):
+    """Runs one configuration in its own directory; returns (energy, counts, errors, events/s).
+
+    seeds (two integers) replace the fixed seeds of the macro, e.g. for
+    independent batches of the same configuration (sweep_scheduler.py).
+    """
+    label = label_of(material, thickness)
+    run_dir = run_dir or os.path.join(WORK_DIR, label)
+    shutil.rmtree(run_dir, ignore_errors=True)
+    os.makedirs(os.path.join(run_dir, "data"))
+
+    # The executable expects macros/, geometry.txt and the physics table cache
+    # in its working directory
+    os.symlink(os.path.abspath("macros"), os.path.join(run_dir, "macros"))
+    os.makedirs("physics_tables", exist_ok=True)
+    os.symlink(os.path.abspath("physics_tables"), os.path.join(run_dir, "physics_tables"))
+    with open(os.path.join(run_dir, "geometry.txt"), "w") as f:
+        f.write(f"material {material}\nthickness {thickness}\noutput none\n")
+    with open(os.path.join(run_dir, "run.mac"), "w") as f:
+        f.write(f"/control/execute {macro}\n")
+        if seeds:
+            f.write(f"/random/setSeeds {seeds[0]} {seeds[1]}\n")
+        f.write(f"/run/beamOn {events}\n")
+
+    start = time.perf_counter()
+    proc = subprocess.run([os.path.abspath(exe), "-m", "run.mac"], cwd=run_dir,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    wall = time.perf_counter() - start
+    with open(os.path.join(run_dir, "run.log"), "w") as f:
+        f.write(proc.stdout)
+    if proc.returncode != 0:
+        sys.exit(f"[spectrum_regression] {label}: exit status {proc.returncode}, "
+                 f"see {run_dir}/run.log")
+
+    # Event-loop time from the run summary; wall time (with startup) otherwise
+    match = re.findall(r"Real=\s*([0-9.eE+-]+)\s*s", proc.stdout)
+    loop_time = float(match[-1]) if match else wall
+
+    spectra = glob.glob(os.path.join(run_dir, "data", "spectrum_*.csv"))
+    if len(spectra) != 1:
+        sys.exit(f"[spectrum_regression] {label}: expected one spectrum file, found {spectra}")
+    columns = read_columns(spectra[0])
+    # A single foil has one scoring plane, the first column after the energy
+    counts_label = next(name for name in columns if name != "Energy_MeV")
+    counts, errors = spectrum_of(columns, counts_label)
+    return columns["Energy_MeV"], counts, errors, events / loop_time
+
+
+def write_reference(path, energy, results, geant4_version=""):
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        header = ["Energy_MeV"]
+        for label in results:
+            header += [label, f"{label}_err"]
+        writer.writerow(header)
+        for i, e in enumerate(energy):
+            row = [f"{e:.6f}"]
+            for counts, errors, _, _ in results.values():
+                row += [f"{counts[i]:.10g}", f"{errors[i]:.10g}"]
+            writer.writerow(row)
+    with open(meta_file_of(path), "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["Label", "Events", "EventsPerSecond", "Geant4Version"])
+        for label, (_, _, rate, events) in results.items():
+            writer.writerow([label, events, f"{rate:.6g}", geant4_version])
+    print(f"[spectrum_regression] Reference written to {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--exe", default="./brems_sim_b4c")
+    parser.add_argument("--reference", default=REFERENCE_CSV)
+    parser.add_argument("--configs", nargs="+", default=CONFIGS,
+                        help="material:thickness_mm, e.g. W:0.1")
+    parser.add_argument("--events", type=int, default=EVENTS)
+    parser.add_argument("--macro", default=MACRO,
+                        help="run macro, e.g. macros/tail_bias.mac to validate a biased source")
+    parser.add_argument("--alpha", type=float, default=ALPHA)
+    parser.add_argument("--tail-energy", type=float, default=TAIL_ENERGY,
+                        help="MeV, lower edge of the tail for the figure of merit")
+    parser.add_argument("--update-reference", action="store_true")
+    parser.add_argument("--shape-only", action="store_true",
+                        help="accept a reference without meta file, compare shapes only")
+    parser.add_argument("--geant4-version", default="",
+                        help="Geant4 version of the executable, stored with the reference")
+    parser.add_argument("--skip-missing", action="store_true",
+                        help="without a stored reference, report the check as skipped (exit 0)")
+    args = parser.parse_args()
+
+    # Check the reference before spending the CPU on the runs
+    if not args.update_reference:
+        missing = None
+        if not os.path.exists(args.reference):
+            missing = (f"{args.reference} not found; store a fixed-seed reference with "
+                       f"--update-reference (make regression_reference) first")
+        elif not args.shape_only and not os.path.exists(meta_file_of(args.reference)):
+            missing = (f"{meta_file_of(args.reference)} not found; the reference needs its "
+                       f"event counts and throughput (or use --shape-only)")
+        if missing and args.skip_missing:
+            print(f"[spectrum_regression] SKIPPED: {missing}")
+            return 0
+        if missing:
+            sys.exit(f"[spectrum_regression] {missing}")
+
+    energy = None
+    results = {}
+    for config in args.configs:
+        material, thickness = config.split(":")
+        label = label_of(material, thickness)
+        print(f"[spectrum_regression] Running {label} ({args.events} events)", flush=True)
+        energy, counts, errors, rate = run_config(args.exe, material, thickness, args.events,
+                                                   args.macro)
+        results[label] = (counts, errors, rate, args.events)
+
+    if args.update_reference:
+        write_reference(args.reference, energy, results, args.geant4_version)
+        return 0
+
+    reference = read_columns(args.reference)
+    meta, versions = read_meta(meta_file_of(args.reference))
+    if args.geant4_version and versions and versions != {args.geant4_version}:
+        print(f"[spectrum_regression] Warning: reference made with Geant4 "
+              f"{', '.join(sorted(versions))}, this build uses {args.geant4_version}")
+    if not np.allclose(reference["Energy_MeV"], energy, atol=1e-6):
+        sys.exit("[spectrum_regression] Reference binning differs from the spectrum binning")
+
+    print()
+    print(f"{'Config':<12}{'chi2/ndf':>16}{'p(chi2)':>11}{'KS D':>10}{'p(KS)':>11}"
+          f"{'ref ev/s':>12}{'new ev/s':>12}{'ratio':>8}{'tail FOM':>10}  result")
+    failed = False
+    for label, (counts, errors, rate, events) in results.items():
+        if label not in reference:
+            print(f"{label:<12}  no reference column")
+            failed = True
+            continue
+        if label not in meta and not args.shape_only:
+            print(f"{label:<12}  no reference meta entry")
+            failed = True
+            continue
+        ref_counts, ref_errors = spectrum_of(reference, label)
+        ref_events, ref_rate = meta.get(label, (None, float("nan")))
+        r = compare(ref_counts, ref_errors, counts, errors, ref_events, events)
+        fom = tail_fom(energy, counts, errors, events, rate, args.tail_energy) / tail_fom(
+            energy, ref_counts, ref_errors, ref_events or 0.0, ref_rate, args.tail_energy)
+        ok = r["p_chi2"] >= args.alpha and r["p_ks"] >= args.alpha
+        failed |= not ok
+        mode = "" if ref_events else " (shape)"
+        print(f"{label:<12}{r['chi2']:>9.1f}/{r['ndf']:<6d}{r['p_chi2']:>11.3g}{r['ks']:>10.4f}"
+              f"{r['p_ks']:>11.3g}{ref_rate:>12.1f}{rate:>12.1f}{rate / ref_rate:>8.2f}{fom:>10.2f}  "
+              f"{'PASS' if ok else 'FAIL'}{mode}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
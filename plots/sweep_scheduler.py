@@ -0,0 +1,192 @@
+"""
+sweep_scheduler.py
+Adaptive event allocation over a material x thickness sweep.
+
+Instead of the same /run/beamOn for every point, the sweep runs in rounds:
+
+  1. a pilot batch of --pilot events per configuration measures its
+     photon yield, per-bin errors and events/s;
+  2. every further round gives each configuration the events it still
+     needs to reach the target relative error, estimated from the
+     1/sqrt(N) scaling of the batches so far (at most --growth times the
+     events it already has, so a noisy pilot cannot overshoot);
+  3. configurations at the target get nothing; the sweep ends when all
+     are there or after --max-rounds.
+
+Giving each configuration exactly the events it needs is the minimum total
+CPU for an equal error everywhere. With --cpu-budget instead of
+--target-rel-error, the common error is the smallest one the budget buys:
+eps^2 = sum_i(t_i r_i^2) / budget, with t_i the seconds per event and r_i
+the relative error of one event.
+
+The error measure is the largest relative error of the spectrum integrated
+over --groups logarithmic energy groups between --emin and --emax (empty
+groups are skipped), so a few empty 2 keV bins in the far tail do not set
+the budget.
+
+Batches are independent runs (different seeds) of macros/regression.mac
+(spectrum_new.mac primaries), merged by adding counts and squared errors.
+The results are written per material in the binned_W.csv layout,
+normalized per primary so that all thicknesses compare directly:
+
+  <output>/sweep_<material>.csv       Energy_MeV,<mat>_<thk>mm,<mat>_<thk>mm_err,...
+  <output>/sweep_<material>_meta.csv  Label,Events,EventsPerSecond,RelError
+
+    cd build
+    python3 ../plots/sweep_scheduler.py --exe ./brems_sim_b4c \\
+        --materials W Ta Pb --thicknesses 0.1 0.25 0.5 1.0 --target-rel-error 0.02
+"""
+
+import argparse
+import csv
+import math
+import os
+import sys
+
+import numpy as np
+
+from spectrum_regression import MACRO, label_of, run_config
+
+# ── SETTINGS ──────────────────────────────────────────────────────────────────
+MATERIALS      = ["W"]
+THICKNESSES    = ["0.1", "0.25", "0.5", "1.0"]
+PILOT_EVENTS   = 20000
+TARGET_ERROR   = 0.02                 # relative error of the worst energy group
+GROWTH         = 8.0                  # max factor of new over accumulated events per round
+MAX_ROUNDS     = 6
+EMIN, EMAX     = 0.01, 10.0           # MeV, range of the error measure
+GROUPS         = 20
+WORK_DIR       = "sweep"
+OUTPUT_DIR     = "../binned_data"
+# ──────────────────────────────────────────────────────────────────────────────
+
+
+class Config:
+    """Accumulated batches of one sweep point."""
+
+    def __init__(self, material, thickness):
+        self.material, self.thickness = material, thickness
+        self.label = label_of(material, thickness)
+        self.energy = None
+        self.counts = self.var = None
+        self.events = 0
+        self.seconds = 0.0
+
+    def add_batch(self, energy, counts, errors, events, rate):
+        if self.energy is None:
+            self.energy, self.counts, self.var = energy, counts.copy(), errors ** 2
+        else:
+            self.counts += counts
+            self.var += errors ** 2
+        self.events += events
+        self.seconds += events / rate
+
+    @property
+    def seconds_per_event(self):
+        return self.seconds / self.events
+
+    def rel_error(self, edges):
+        """Largest relative error of the group integrals (0 without content)."""
+        worst = 0.0
+        group = np.digitize(self.energy, edges) - 1
+        for g in range(len(edges) - 1):
+            in_group = group == g
+            total = self.counts[in_group].sum()
+            if total > 0.0:
+                worst = max(worst, math.sqrt(self.var[in_group].sum()) / total)
+        return worst
+
+    def events_needed(self, target, edges):
+        """Total events for the target error, from error ~ 1/sqrt(N)."""
+        r1 = self.rel_error(edges) * math.sqrt(self.events)   # error of one event
+        return int(math.ceil((r1 / target) ** 2))
+
+
+def common_target(configs, budget, edges):
+    """Smallest common error a CPU budget (s, event loops only) buys."""
+    cost = sum(c.seconds_per_event * c.rel_error(edges) ** 2 * c.events for c in configs)
+    return math.sqrt(cost / budget)
+
+
+def write_outputs(configs, edges, output_dir):
+    os.makedirs(output_dir, exist_ok=True)
+    for material in sorted({c.material for c in configs}):
+        group = [c for c in configs if c.material == material]
+        path = os.path.join(output_dir, f"sweep_{material}.csv")
+        with open(path, "w", newline="") as f:
+            writer = csv.writer(f)
+            header = ["Energy_MeV"]
+            for c in group:
+                header += [c.label, f"{c.label}_err"]
+            writer.writerow(header)
+            for i, e in enumerate(group[0].energy):
+                row = [f"{e:.6f}"]
+                for c in group:
+                    row += [f"{c.counts[i] / c.events:.10g}",
+                            f"{math.sqrt(c.var[i]) / c.events:.10g}"]
+                writer.writerow(row)
+        with open(os.path.join(output_dir, f"sweep_{material}_meta.csv"), "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["Label", "Events", "EventsPerSecond", "RelError"])
+            for c in group:
+                writer.writerow([c.label, c.events, f"{1.0 / c.seconds_per_event:.6g}",
+                                 f"{c.rel_error(edges):.4g}"])
+        print(f"[sweep_scheduler] Wrote {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--exe", default="./brems_sim_b4c")
+    parser.add_argument("--macro", default=MACRO)
+    parser.add_argument("--materials", nargs="+", default=MATERIALS)
+    parser.add_argument("--thicknesses", nargs="+", default=THICKNESSES, help="mm")
+    parser.add_argument("--pilot", type=int, default=PILOT_EVENTS, help="pilot events")
+    goal = parser.add_mutually_exclusive_group()
+    goal.add_argument("--target-rel-error", type=float, default=TARGET_ERROR)
+    goal.add_argument("--cpu-budget", type=float, help="seconds of event loop, all configs")
+    parser.add_argument("--growth", type=float, default=GROWTH)
+    parser.add_argument("--max-rounds", type=int, default=MAX_ROUNDS)
+    parser.add_argument("--emin", type=float, default=EMIN, help="MeV")
+    parser.add_argument("--emax", type=float, default=EMAX, help="MeV")
+    parser.add_argument("--groups", type=int, default=GROUPS)
+    parser.add_argument("--output", default=OUTPUT_DIR)
+    args = parser.parse_args()
+
+    edges = np.geomspace(args.emin, args.emax, args.groups + 1)
+    configs = [Config(m, t) for m in args.materials for t in args.thicknesses]
+    allocation = {c.label: args.pilot for c in configs}
+    target = args.target_rel_error
+
+    for round_no in range(args.max_rounds):
+        for n, c in enumerate(configs):
+            events = allocation[c.label]
+            if events <= 0:
+                continue
+            print(f"[sweep_scheduler] Round {round_no}: {c.label} +{events} events", flush=True)
+            seeds = (1000003 * (round_no + 1) + n, 7919 * (n + 1) + round_no)
+            run_dir = os.path.join(WORK_DIR, f"{c.label}_r{round_no}")
+            energy, counts, errors, rate = run_config(args.exe, c.material, c.thickness, events,
+                                                      args.macro, seeds, run_dir)
+            c.add_batch(energy, counts, errors, events, rate)
+
+        if args.cpu_budget:
+            target = common_target(configs, args.cpu_budget, edges)
+
+        print()
+        print(f"{'Config':<12}{'events':>12}{'ev/s':>10}{'rel.err':>10}{'needed':>12}{'next':>12}")
+        for c in configs:
+            needed = c.events_needed(target, edges)
+            allocation[c.label] = int(min(max(0, needed - c.events), args.growth * c.events))
+            print(f"{c.label:<12}{c.events:>12d}{1.0 / c.seconds_per_event:>10.1f}"
+                  f"{c.rel_error(edges):>10.4f}{needed:>12d}{allocation[c.label]:>12d}")
+        print(f"[sweep_scheduler] Target relative error {target:.4g}\n", flush=True)
+
+        if all(events == 0 for events in allocation.values()):
+            break
+
+    write_outputs(configs, edges, args.output)
+    return 0 if all(c.rel_error(edges) <= target * 1.05 for c in configs) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,486 @@
+/// \file scaling_study.cc
+/// \brief Thread-scalability benchmark of the B4c production code paths
+///
+/// Runs the same workload at 1, 2, 4 ... N worker threads and reports
+/// events/s, speedup, parallel efficiency, per-thread idle time and
+/// allocator statistics as a table, an efficiency curve and a CSV file.
+///
+/// Allocator contention is measured, not inferred from the footprint: this
+/// executable replaces the global operator new and delete with malloc and
+/// free timed on one call in kAllocSampleEvery (G4Allocator pools grow
+/// through operator new, so their page allocations are included). The
+/// time per call at 1 thread is the uncontended cost; the extra time per
+/// call at N threads, times the calls per event, is the allocator's share
+/// of the busy time lost to contention ("alloc loss"). Time inside
+/// G4Allocator::MallocSingle itself is not timed: its free lists are
+/// thread-local and take no lock.
+///
+/// The number of threads of a G4MTRunManager is fixed once it has been
+/// initialised, so every thread count runs in a child process (this same
+/// executable started with --child). The child uses the production
+/// DetectorConstruction, physics list and ActionInitialization; only the
+/// event action is wrapped to time each event and sample the allocators.
+///
+/// Usage:
+///   scaling_study [-m setup.mac] [-n events] [-w warmup] [-t maxThreads]
+///                 [-o scaling_study.csv]
+
+#include "ActionInitialization.hh"
+#include "DetectorConstruction.hh"
+#include "ScoringParallelWorld.hh"
+#include "ScoringWindowPhysics.hh"
+#include "WeightWindowPhysics.hh"
+#include "TrackInformation.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4MTRunManager.hh"
+#include "G4ParallelWorldPhysics.hh"
+#include "G4PhysListFactory.hh"
+#include "G4RunManagerFactory.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4UImanager.hh"
+#include "G4UserEventAction.hh"
+#include "Randomize.hh"
+
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Heap calls of one thread: all of them counted, one in kAllocSampleEvery
+/// timed (the clock costs about as much as an uncontended malloc)
+constexpr std::uint64_t kAllocSampleEvery = 64;
+
+struct AllocCounters
+{
+  std::uint64_t calls = 0;
+  std::uint64_t sampledCalls = 0;
+  std::uint64_t sampledNs = 0;
+};
+
+thread_local AllocCounters tAllocCounters;
+
+template <typename Call>
+auto TimedHeapCall(Call call)
+{
+  auto& counters = tAllocCounters;
+  if (counters.calls++ % kAllocSampleEvery != 0) return call();
+  auto start = Clock::now();
+  auto result = call();
+  counters.sampledNs += static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+  ++counters.sampledCalls;
+  return result;
+}
+
+void* TimedMalloc(std::size_t size)
+{
+  void* p = TimedHeapCall([size] { return std::malloc(size ? size : 1); });
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void TimedFree(void* p)
+{
+  if (p) TimedHeapCall([p] { std::free(p); return 0; });
+}
+
+}  // namespace
+
+// Replaceable global allocation functions of this executable (and of the
+// Geant4 libraries it loads). The nothrow and aligned forms keep their
+// library versions, which end up in these or use their own matching pair.
+void* operator new(std::size_t size) { return TimedMalloc(size); }
+void* operator new[](std::size_t size) { return TimedMalloc(size); }
+void operator delete(void* p) noexcept { TimedFree(p); }
+void operator delete[](void* p) noexcept { TimedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { TimedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { TimedFree(p); }
+
+namespace
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Counters of one worker thread. Written only by that worker, read by the
+/// master once beamOn has returned.
+struct WorkerStats
+{
+  G4int threadId = -1;
+  G4double busySeconds = 0.;
+  G4long events = 0;
+  std::size_t allocatorBytes = 0;  ///< G4Allocator pools owned by the thread
+  AllocCounters heap;  ///< Copy of the thread's heap-call counters
+};
+
+std::mutex gStatsMutex;
+std::vector<std::unique_ptr<WorkerStats>> gStats;
+
+WorkerStats* RegisterWorker()
+{
+  std::lock_guard<std::mutex> lock(gStatsMutex);
+  gStats.push_back(std::make_unique<WorkerStats>());
+  gStats.back()->threadId = G4Threading::G4GetThreadId();
+  return gStats.back().get();
+}
+
+template <typename T>
+std::size_t PoolBytes(G4Allocator<T>* allocator)
+{
+  return allocator ? allocator->GetAllocatedSize() : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Forwards to the production event action and times the whole event
+class TimedEventAction : public G4UserEventAction
+{
+  public:
+    TimedEventAction(G4UserEventAction* production, WorkerStats* stats)
+      : fProduction(production), fStats(stats)
+    {}
+    ~TimedEventAction() override { delete fProduction; }
+
+    void BeginOfEventAction(const G4Event* event) override
+    {
+      fStart = Clock::now();
+      if (fProduction) fProduction->BeginOfEventAction(event);
+    }
+
+    void EndOfEventAction(const G4Event* event) override
+    {
+      if (fProduction) fProduction->EndOfEventAction(event);
+      fStats->busySeconds += std::chrono::duration<G4double>(Clock::now() - fStart).count();
+      ++fStats->events;
+      // G4Allocator pools only grow, so the last sample is the peak
+      fStats->allocatorBytes = PoolBytes(aTrackAllocator()) + PoolBytes(pDynamicParticleAllocator())
+                               + PoolBytes(B4c::TrackInformationAllocator);
+      fStats->heap = tAllocCounters;
+    }
+
+  private:
+    G4UserEventAction* fProduction = nullptr;
+    WorkerStats* fStats = nullptr;
+    Clock::time_point fStart;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// The production actions, with the event action wrapped for timing
+class ScalingActionInitialization : public B4c::ActionInitialization
+{
+  public:
+    void Build() const override
+    {
+      B4c::ActionInitialization::Build();
+      auto runManager = G4RunManager::GetRunManager();
+      auto production = const_cast<G4UserEventAction*>(runManager->GetUserEventAction());
+      SetUserAction(new TimedEventAction(production, RegisterWorker()));
+    }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+struct Options
+{
+  G4String setupMacro = "macros/scaling.mac";
+  G4int events = 20000;
+  G4int warmup = 1000;
+  G4int maxThreads = G4Threading::G4GetNumberOfCores();
+  G4String csvFile = "scaling_study.csv";
+  G4int childThreads = 0;  ///< > 0 in a child process
+  G4String resultFile;
+};
+
+/// One row of the study, as written by a child and read by the parent
+struct Result
+{
+  G4int threads = 0;
+  G4double wallSeconds = 0.;
+  G4double eventsPerSecond = 0.;
+  G4double meanIdleFraction = 0.;
+  G4double maxIdleFraction = 0.;
+  G4long voluntarySwitches = 0;
+  G4long involuntarySwitches = 0;
+  G4long minorFaults = 0;
+  G4double poolFootprintMB = 0.;  ///< G4Allocator pools, a size, not a contention measure
+  G4double heapInUseMB = 0.;  ///< mallinfo2, idem
+  G4double heapCallsPerEvent = 0.;  ///< operator new and delete calls
+  G4double heapNsPerCall = 0.;  ///< Sampled mean time of one call
+  G4double busyUsPerEvent = 0.;
+};
+
+G4double MallocMB()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  auto info = mallinfo2();
+  return static_cast<G4double>(info.uordblks + info.hblkhd) / (1024. * 1024.);
+#else
+  return 0.;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Result RunChild(const Options& opt)
+{
+  CLHEP::HepRandom::setTheSeed(12345);
+
+  auto runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::MTOnly);
+  static_cast<G4MTRunManager*>(runManager)->SetNumberOfThreads(opt.childThreads);
+
+  runManager->SetUserInitialization(new B4c::DetectorConstruction());
+  G4PhysListFactory factory;
+  auto physicsList = factory.GetReferencePhysList("FTFP_BERT_LIV");
+  physicsList->RegisterPhysics(new B4c::ScoringWindowPhysics());
+  physicsList->RegisterPhysics(new B4c::WeightWindowPhysics());
+  physicsList->RegisterPhysics(
+    new G4ParallelWorldPhysics(B4c::ScoringParallelWorld::kWorldName));
+  runManager->SetUserInitialization(physicsList);
+  runManager->SetUserInitialization(new ScalingActionInitialization());
+
+  auto UImanager = G4UImanager::GetUIpointer();
+  UImanager->ApplyCommand("/control/execute " + opt.setupMacro);
+  runManager->SetPrintProgress(0);
+
+  if (opt.warmup > 0) runManager->BeamOn(opt.warmup);
+
+  // Counters are cumulative, the measured run is the difference
+  std::vector<WorkerStats> before;
+  for (const auto& stats : gStats) before.push_back(*stats);
+  rusage usageBefore{};
+  getrusage(RUSAGE_SELF, &usageBefore);
+
+  auto start = Clock::now();
+  runManager->BeamOn(opt.events);
+  G4double wall = std::chrono::duration<G4double>(Clock::now() - start).count();
+
+  rusage usageAfter{};
+  getrusage(RUSAGE_SELF, &usageAfter);
+
+  Result result;
+  result.threads = opt.childThreads;
+  result.wallSeconds = wall;
+  result.eventsPerSecond = wall > 0. ? opt.events / wall : 0.;
+  result.voluntarySwitches = usageAfter.ru_nvcsw - usageBefore.ru_nvcsw;
+  result.involuntarySwitches = usageAfter.ru_nivcsw - usageBefore.ru_nivcsw;
+  result.minorFaults = usageAfter.ru_minflt - usageBefore.ru_minflt;
+  result.heapInUseMB = MallocMB();
+
+  G4double idleSum = 0.;
+  G4double busySum = 0.;
+  G4long eventSum = 0;
+  std::uint64_t heapCalls = 0, sampledCalls = 0, sampledNs = 0;
+  std::size_t allocatorBytes = 0;
+  for (std::size_t i = 0; i < gStats.size(); ++i) {
+    G4double busy = gStats[i]->busySeconds - (i < before.size() ? before[i].busySeconds : 0.);
+    busySum += busy;
+    eventSum += gStats[i]->events - (i < before.size() ? before[i].events : 0);
+    AllocCounters heapBefore = i < before.size() ? before[i].heap : AllocCounters();
+    heapCalls += gStats[i]->heap.calls - heapBefore.calls;
+    sampledCalls += gStats[i]->heap.sampledCalls - heapBefore.sampledCalls;
+    sampledNs += gStats[i]->heap.sampledNs - heapBefore.sampledNs;
+    G4double idle = wall > 0. ? std::max(0., 1. - busy / wall) : 0.;
+    idleSum += idle;
+    result.maxIdleFraction = std::max(result.maxIdleFraction, idle);
+    allocatorBytes += gStats[i]->allocatorBytes;
+    G4cout << "[scaling_study] thread " << gStats[i]->threadId << ": busy " << busy << " s, "
+           << (gStats[i]->events - (i < before.size() ? before[i].events : 0)) << " events"
+           << G4endl;
+  }
+  result.meanIdleFraction = gStats.empty() ? 0. : idleSum / gStats.size();
+  result.poolFootprintMB = static_cast<G4double>(allocatorBytes) / (1024. * 1024.);
+  if (eventSum > 0) {
+    result.heapCallsPerEvent = static_cast<G4double>(heapCalls) / eventSum;
+    result.busyUsPerEvent = 1e6 * busySum / eventSum;
+  }
+  if (sampledCalls > 0) result.heapNsPerCall = static_cast<G4double>(sampledNs) / sampledCalls;
+
+  delete runManager;
+  return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WriteResult(const Result& r, std::ostream& out)
+{
+  out << r.threads << "," << r.wallSeconds << "," << r.eventsPerSecond << ","
+      << r.meanIdleFraction << "," << r.maxIdleFraction << "," << r.voluntarySwitches << ","
+      << r.involuntarySwitches << "," << r.minorFaults << "," << r.poolFootprintMB << ","
+      << r.heapInUseMB << "," << r.heapCallsPerEvent << "," << r.heapNsPerCall << ","
+      << r.busyUsPerEvent;
+}
+
+G4bool ReadResult(const std::string& line, Result& r)
+{
+  std::istringstream in(line);
+  char c;
+  return static_cast<bool>(in >> r.threads >> c >> r.wallSeconds >> c >> r.eventsPerSecond >> c
+                           >> r.meanIdleFraction >> c >> r.maxIdleFraction >> c
+                           >> r.voluntarySwitches >> c >> r.involuntarySwitches >> c
+                           >> r.minorFaults >> c >> r.poolFootprintMB >> c >> r.heapInUseMB >> c
+                           >> r.heapCallsPerEvent >> c >> r.heapNsPerCall >> c
+                           >> r.busyUsPerEvent);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Report(const Options& opt, const std::vector<Result>& results)
+{
+  if (results.empty()) return;
+  // Per-thread rate and heap-call time of the smallest configuration are
+  // the reference
+  G4double base = results.front().eventsPerSecond / results.front().threads;
+  G4double baseNsPerCall = results.front().heapNsPerCall;
+
+  std::ofstream csv(opt.csvFile, std::ios::out | std::ios::trunc);
+  csv << "Threads,Wall_s,EventsPerSecond,MeanIdleFraction,MaxIdleFraction,VoluntarySwitches,"
+         "InvoluntarySwitches,MinorFaults,PoolFootprintMB,HeapInUseMB,HeapCallsPerEvent,"
+         "HeapNsPerCall,BusyUsPerEvent,Speedup,Efficiency,HeapFraction,HeapContentionLoss\n";
+
+  std::cout << "\n[scaling_study] " << opt.events << " events per point, setup "
+            << opt.setupMacro << "\n\n"
+            << std::setw(8) << "threads" << std::setw(12) << "events/s" << std::setw(10)
+            << "speedup" << std::setw(8) << "eff." << std::setw(11) << "idle mean"
+            << std::setw(10) << "idle max" << std::setw(11) << "vol. csw" << std::setw(12)
+            << "invol. csw" << std::setw(11) << "pool size" << std::setw(10) << "heap size"
+            << std::setw(10) << "heap ns" << std::setw(9) << "heap %" << std::setw(12)
+            << "alloc loss" << "\n";
+
+  std::vector<G4double> efficiency;
+  for (const auto& r : results) {
+    G4double speedup = base > 0. ? r.eventsPerSecond / base : 0.;
+    efficiency.push_back(speedup / r.threads);
+
+    // Share of the busy time in heap calls, and the part of it that is
+    // contention: the extra time per call over the single-thread cost
+    G4double heapFraction = 0., contentionLoss = 0.;
+    if (r.busyUsPerEvent > 0.) {
+      heapFraction = 1e-3 * r.heapCallsPerEvent * r.heapNsPerCall / r.busyUsPerEvent;
+      contentionLoss = std::max(0., 1e-3 * r.heapCallsPerEvent * (r.heapNsPerCall - baseNsPerCall)
+                                      / r.busyUsPerEvent);
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << std::setw(8) << r.threads << std::setw(12)
+              << r.eventsPerSecond << std::setw(10) << speedup << std::setw(8)
+              << efficiency.back() << std::setw(10) << 100. * r.meanIdleFraction << "%"
+              << std::setw(9) << 100. * r.maxIdleFraction << "%" << std::setw(11)
+              << r.voluntarySwitches << std::setw(12) << r.involuntarySwitches << std::setw(8)
+              << r.poolFootprintMB << " MB" << std::setw(7) << r.heapInUseMB << " MB"
+              << std::setw(10) << r.heapNsPerCall << std::setw(8) << 100. * heapFraction << "%"
+              << std::setw(11) << 100. * contentionLoss << "%\n";
+
+    WriteResult(r, csv);
+    csv << "," << speedup << "," << efficiency.back() << "," << heapFraction << ","
+        << contentionLoss << "\n";
+  }
+
+  // Efficiency curve, one bar per thread count
+  std::cout << "\n  parallel efficiency\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    auto width = static_cast<int>(std::clamp(efficiency[i], 0., 1.) * 50. + 0.5);
+    std::cout << std::setw(6) << results[i].threads << " |" << std::string(width, '#')
+              << std::string(50 - width, ' ') << "| " << std::setprecision(0)
+              << 100. * efficiency[i] << "%\n";
+  }
+  std::cout << std::defaultfloat << "\n[scaling_study] Table written to " << opt.csvFile
+            << std::endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int RunStudy(const Options& opt, const char* self)
+{
+  std::vector<G4int> threadCounts;
+  for (G4int n = 1; n < opt.maxThreads; n *= 2)
+    threadCounts.push_back(n);
+  threadCounts.push_back(opt.maxThreads);
+
+  std::vector<Result> results;
+  for (auto n : threadCounts) {
+    std::string resultFile = "scaling_study_t" + std::to_string(n) + ".result";
+    std::string logFile = "scaling_study_t" + std::to_string(n) + ".log";
+    std::ostringstream command;
+    command << "\"" << self << "\" --child " << n << " -m \"" << opt.setupMacro << "\" -n "
+            << opt.events << " -w " << opt.warmup << " --result \"" << resultFile << "\" > \""
+            << logFile << "\" 2>&1";
+
+    std::cout << "[scaling_study] " << n << " thread(s) ..." << std::flush;
+    if (std::system(command.str().c_str()) != 0) {
+      std::cout << " failed, see " << logFile << std::endl;
+      continue;
+    }
+
+    std::ifstream in(resultFile);
+    std::string line;
+    Result r;
+    if (std::getline(in, line) && ReadResult(line, r)) {
+      std::cout << " " << r.eventsPerSecond << " events/s" << std::endl;
+      results.push_back(r);
+    }
+    else {
+      std::cout << " no result, see " << logFile << std::endl;
+    }
+    std::remove(resultFile.c_str());
+  }
+
+  Report(opt, results);
+  return results.empty() ? 1 : 0;
+}
+
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  for (G4int i = 1; i + 1 < argc; i += 2) {
+    std::string flag = argv[i];
+    std::string value = argv[i + 1];
+    if (flag == "-m") opt.setupMacro = value;
+    else if (flag == "-n") opt.events = std::stoi(value);
+    else if (flag == "-w") opt.warmup = std::stoi(value);
+    else if (flag == "-t") opt.maxThreads = std::max(1, std::stoi(value));
+    else if (flag == "-o") opt.csvFile = value;
+    else if (flag == "--child") opt.childThreads = std::stoi(value);
+    else if (flag == "--result") opt.resultFile = value;
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [-m setup.mac] [-n events] [-w warmup] [-t maxThreads] [-o out.csv]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (opt.childThreads <= 0) return RunStudy(opt, argv[0]);
+
+  auto result = RunChild(opt);
+  std::ofstream out(opt.resultFile, std::ios::out | std::ios::trunc);
+  WriteResult(result, out);
+  out << "\n";
+  return 0;
+}
@@ -6,8 +6,13 @@
 #include "ActionInitialization.hh"
 
 #include "EventAction.hh"
+#include "PointDetectorEstimator.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "ProfilingSteppingAction.hh"
 #include "RunAction.hh"
+#include "TracingSteppingAction.hh"
+
+#include "G4Threading.hh"
 
 using namespace B4;
 
@@ -16,8 +21,26 @@ namespace B4c
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace
+{
+// Creates the /B4c/profile/, /B4c/ned/ and /B4c/trace/ commands before any
+// macro runs. The run manager calls BuildForMaster (MT) or Build (serial,
+// e.g. -t 1) when the action initialization is set, so one of the two
+// creates them on the thread that reads the macros.
+void CreateMasterCommands()
+{
+  StepProfiler::Instance();
+  PointDetectorStore::Instance();
+  EventTracer::Instance();
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void ActionInitialization::BuildForMaster() const
 {
+  CreateMasterCommands();
+
   SetUserAction(new RunAction);
 }
 
@@ -25,6 +48,9 @@ void ActionInitialization::BuildForMaster() const
 
 void ActionInitialization::Build() const
 {
+  // The serial run manager never calls BuildForMaster
+  if (!G4Threading::IsMultithreadedApplication()) CreateMasterCommands();
+
   SetUserAction(new PrimaryGeneratorAction);
   SetUserAction(new RunAction);
   SetUserAction(new EventAction);
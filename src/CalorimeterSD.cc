@@ -1,120 +1,203 @@
 /// \file B4/B4c/src/CalorimeterSD.cc
-/// \brief Implementation of the B4c::CalorimeterSD class
+/// \brief Implementation of the B4c::CalorimeterSD class template
 
 #include "CalorimeterSD.hh"
 #include "DetectorConstruction.hh"
+#include "TrackInformation.hh"
 
-#include "G4HCofThisEvent.hh"
-#include "G4SDManager.hh"
+#include "G4Box.hh"
+#include "G4Event.hh"
+#include "G4GeometryTolerance.hh"
 #include "G4Step.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4Threading.hh"
+#include "G4VTouchable.hh"
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <utility>
 
 namespace B4c
 {
 
-CalorimeterSD::CalorimeterSD(const G4String& name,
-                             const G4String& hitsCollectionName,
-                             G4int nofCells)
-  : G4VSensitiveDetector(name), fNofCells(nofCells)
+template<class Filter, class Sink>
+CalorimeterSD<Filter, Sink>::CalorimeterSD(const G4String& name, G4int nofPlanes,
+                                           G4double scoreEminMeV, G4double scoreEmaxMeV,
+                                           Sink&& sink)
+  : G4VSensitiveDetector(name),
+    fNofPlanes(nofPlanes),
+    fScoreEminMeV(scoreEminMeV),
+    fScoreEmaxMeV(scoreEmaxMeV),
+    fSink(std::move(sink))
+{}
+
+template<class Filter, class Sink>
+void CalorimeterSD<Filter, Sink>::Initialize(G4HCofThisEvent*)
 {
-  collectionName.insert(hitsCollectionName);
-
-  auto detConst = static_cast<const B4c::DetectorConstruction*>(
-      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  // The event ID of the records, looked up once per event
+  auto* event = G4RunManager::GetRunManager()->GetCurrentEvent();
+  fSink.BeginOfEvent(event ? event->GetEventID() : 0);
+}
 
-  G4String baseFilename = detConst->GetOutputFileName();
-
-  // In multithreaded mode each worker thread gets its own file to avoid
-  // race conditions. Files are named e.g. loweroutput_G4_W_1mm_t0.txt
-  // The plotting script merges them automatically.
-  G4String filename = baseFilename;
-  if (G4Threading::IsWorkerThread()) {
-    // Insert thread ID before .txt
-    G4String threadSuffix = "_t" + std::to_string(G4Threading::G4GetThreadId());
-    auto dotPos = baseFilename.rfind('.');
-    if (dotPos != G4String::npos)
-      filename = baseFilename.substr(0, dotPos) + threadSuffix + baseFilename.substr(dotPos);
-    else
-      filename = baseFilename + threadSuffix;
+template<class Filter, class Sink>
+G4bool CalorimeterSD<Filter, Sink>::ProcessHits(G4Step* step, G4TouchableHistory*)
+{
+  auto* track = step->GetTrack();
+  if (!fFilter.Accept(*track)) return true;
+
+  // Only steps that end on the boundary of a slab of the scoring world: the
+  // plane is scored on the step that crosses it, before any post-step
+  // biasing (weight-window splitting or roulette) at its end
+  auto* postStep = step->GetPostStepPoint();
+  if (postStep->GetStepStatus() != fGeomBoundary) return true;
+
+  // Scoring plane from the face the particle leaves through: slab k lies
+  // between interfaces k - 1 and k (see ScoringParallelWorld). Exits
+  // through the sides are not crossings of a plane, and neither are the
+  // front face of slab 0 (plane -1) and the back face of the trailing slab
+  // (plane fNofPlanes), which the range check drops.
+  auto* preStep = step->GetPreStepPoint();
+  const auto* touchable = preStep->GetTouchable();
+  auto* box = static_cast<const G4Box*>(touchable->GetSolid());
+  G4double localZ =
+    touchable->GetHistory()->GetTopTransform().TransformPoint(postStep->GetPosition()).z();
+  G4double tolerance = G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
+  G4int plane = touchable->GetCopyNumber();
+  if (std::abs(localZ + box->GetZHalfLength()) < tolerance)
+    plane -= 1;
+  else if (std::abs(localZ - box->GetZHalfLength()) >= tolerance)
+    return true;
+  if (plane < 0 || plane >= fNofPlanes) return true;
+
+  // Scoring window, at the plane
+  G4double energyMeV = postStep->GetKineticEnergy() / CLHEP::MeV;
+  if (energyMeV < fScoreEminMeV || energyMeV > fScoreEmaxMeV) return true;
+
+  // Only record each track once per plane (first crossing).
+  // The flag travels with the track, so there is no per-event lookup;
+  // weight-window copies made at the end of this step inherit it.
+  auto* info = static_cast<TrackInformation*>(track->GetUserInformation());
+  if (info && info->IsScored(plane)) return true;
+  if (!info) {
+    info = new TrackInformation();
+    track->SetUserInformation(info);
   }
+  info->SetScored(plane);
 
-  outputFile.open(filename, std::ios::out | std::ios::trunc);
-  if (outputFile.is_open()) {
-    outputFile << "EventID,TrackID,ParentID,Particle,KineticEnergy,Volume,DetectorID\n";
-    G4cout << "[CalorimeterSD] Thread " << G4Threading::G4GetThreadId()
-           << " writing to " << filename << G4endl;
-  } else {
-    G4cerr << "[CalorimeterSD] Warning: Could not open " << filename << G4endl;
-  }
-}
+  // Weight carried across the plane: the weight of the step, whatever
+  // post-step process runs before or after this one
+  fSink.Record({track, plane, energyMeV, preStep->GetWeight()});
 
-CalorimeterSD::~CalorimeterSD()
-{
-  if (outputFile.is_open())
-    outputFile.close();
+  return true;
 }
 
-void CalorimeterSD::Initialize(G4HCofThisEvent* hce)
+template<class Filter, class Sink>
+void CalorimeterSD<Filter, Sink>::EndOfEvent(G4HCofThisEvent*)
 {
-  fHitsCollection = new CalorHitsCollection(SensitiveDetectorName, collectionName[0]);
+  fSink.EndOfEvent();
+}
 
-  auto hcID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
-  hce->AddHitsCollection(hcID, fHitsCollection);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  for (G4int i = 0; i < fNofCells + 1; ++i)
-    fHitsCollection->insert(new CalorHit());
+namespace
+{
 
-  fLoggedTracks.clear();
+// In multithreaded mode each worker thread gets its own file to avoid
+// race conditions. Files are named e.g. loweroutput_G4_W_1mm_t0.txt
+// The plotting script merges them automatically.
+G4String ThreadFileName(const G4String& baseFilename)
+{
+  if (!G4Threading::IsWorkerThread()) return baseFilename;
+
+  // Insert thread ID before .txt
+  G4String threadSuffix = "_t" + std::to_string(G4Threading::G4GetThreadId());
+  auto dotPos = baseFilename.rfind('.');
+  if (dotPos != G4String::npos)
+    return baseFilename.substr(0, dotPos) + threadSuffix + baseFilename.substr(dotPos);
+  return baseFilename + threadSuffix;
 }
 
-G4bool CalorimeterSD::ProcessHits(G4Step* step, G4TouchableHistory*)
+struct SDArguments
 {
-  auto* track = step->GetTrack();
-  if (!track) return false;
+  const G4String& name;
+  const DetectorConstruction& detector;
+};
 
-  // Only photons
-  if (track->GetDefinition()->GetParticleName() != "gamma") return true;
+template<class Filter, class Sink>
+G4VSensitiveDetector* MakeSD(const SDArguments& args, Sink&& sink)
+{
+  return new CalorimeterSD<Filter, Sink>(
+    args.name, static_cast<G4int>(args.detector.GetLayers().size()),
+    args.detector.GetScoreEminMeV(), args.detector.GetScoreEmaxMeV(), std::move(sink));
+}
 
-  // Only record each track once (first entry into the detector plane)
-  G4int trackID = track->GetTrackID();
-  if (fLoggedTracks.count(trackID) > 0) return true;
-  fLoggedTracks.insert(trackID);
+// Records alone, or after the spectra
+template<class Filter, class Records>
+G4VSensitiveDetector* MakeWithRecords(const SDArguments& args, Records&& records)
+{
+  if (!args.detector.GetSpectraEnabled()) return MakeSD<Filter>(args, std::move(records));
+  auto nofPlanes = static_cast<G4int>(args.detector.GetLayers().size());
+  return MakeSD<Filter>(args, SinkPair<HistogramSink<Filter>, Records>(
+                                HistogramSink<Filter>(nofPlanes), std::move(records)));
+}
 
-  auto* event = G4RunManager::GetRunManager()->GetCurrentEvent();
-  if (!event) return true;
-
-  auto eventID       = event->GetEventID();
-  auto parentID      = track->GetParentID();
-  auto kineticEnergy = track->GetKineticEnergy();
-
-  if (outputFile.is_open()) {
-    outputFile << eventID       << ","
-               << trackID       << ","
-               << parentID      << ","
-               << "gamma"       << ","
-               << kineticEnergy / CLHEP::MeV << ","
-               << "Detector"    << ","
-               << 0             << "\n";
+template<class Filter>
+G4VSensitiveDetector* MakeForFilter(const SDArguments& args)
+{
+  const auto& detConst = args.detector;
+  G4String filename = ThreadFileName(detConst.GetOutputFileName());
+  G4String format = detConst.GetOutputFormat();
+
+  if (format == "compressed") {
+    // Same name with the .b4h extension of the block-compressed format
+    auto dotPos = filename.rfind('.');
+    filename = (dotPos != G4String::npos ? filename.substr(0, dotPos) : filename) + ".b4h";
+
+    CompressedHitWriter::Codec codec;
+    if (!CompressedHitWriter::ParseCodec(detConst.GetOutputCodec(), codec)) {
+      G4cerr << "[CalorimeterSD] Warning: unknown codec " << detConst.GetOutputCodec()
+             << ", using zstd" << G4endl;
+      codec = CompressedHitWriter::Codec::zstd;
+    }
+    auto writer = std::make_unique<CompressedHitWriter>(
+      filename, codec, detConst.GetCompressionLevel(), Filter::kParticleLabel);
+    if (writer->IsOpen()) {
+      G4cout << "[CalorimeterSD] Thread " << G4Threading::G4GetThreadId()
+             << " writing compressed records to " << filename << G4endl;
+      return MakeWithRecords<Filter>(args, BinaryRecordSink(std::move(writer)));
+    }
+    G4cerr << "[CalorimeterSD] Warning: Could not open " << filename << G4endl;
+  }
+  else if (format == "csv") {
+    std::ofstream outputFile(filename, std::ios::out | std::ios::trunc);
+    if (outputFile.is_open()) {
+      G4cout << "[CalorimeterSD] Thread " << G4Threading::G4GetThreadId()
+             << " writing to " << filename << G4endl;
+      return MakeWithRecords<Filter>(args, CsvRecordSink(std::move(outputFile)));
+    }
+    G4cerr << "[CalorimeterSD] Warning: Could not open " << filename << G4endl;
   }
 
-  return true;
+  // No records
+  if (!detConst.GetSpectraEnabled()) return MakeSD<Filter>(args, NullSink());
+  return MakeSD<Filter>(args,
+                        HistogramSink<Filter>(static_cast<G4int>(detConst.GetLayers().size())));
 }
 
-void CalorimeterSD::EndOfEvent(G4HCofThisEvent*)
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSensitiveDetector* CreateCalorimeterSD(const G4String& name)
 {
-  // NOTE: flush removed — OS buffers writes automatically and flushes
-  // on close, which is far faster than flushing every single event.
-  // The file is safely closed in the destructor when the run ends.
-
-  if (verboseLevel > 1) {
-    auto nofHits = fHitsCollection->entries();
-    G4cout << G4endl << "-------->Hits Collection: in this event they are "
-           << nofHits << " hits in the calorimeter: " << G4endl;
-    for (std::size_t i = 0; i < nofHits; ++i)
-      (*fHitsCollection)[i]->Print();
-  }
+  auto detConst = static_cast<const B4c::DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+  SDArguments args{name, *detConst};
+  if (detConst->GetScoredParticles() == "charged") return MakeForFilter<ChargedFilter>(args);
+  return MakeForFilter<GammaFilter>(args);
 }
 
 } // namespace B4c
@@ -0,0 +1,155 @@
+/// \file B4/B4c/src/CompressedHitWriter.cc
+/// \brief Implementation of the B4c::CompressedHitWriter class
+
+#include "CompressedHitWriter.hh"
+
+#ifdef B4C_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef B4C_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace B4c
+{
+
+namespace
+{
+constexpr std::uint32_t kFormatVersion = 3;
+
+const char* kHeaderLine = "EventID,TrackID,ParentID,Particle,KineticEnergy,Volume,DetectorID,Weight\n";
+
+void PutU32(std::ofstream& out, std::uint32_t value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CompressedHitWriter::IsAvailable(Codec codec)
+{
+  switch (codec) {
+    case Codec::none:
+      return true;
+    case Codec::zstd:
+#ifdef B4C_HAVE_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    case Codec::lz4:
+#ifdef B4C_HAVE_LZ4
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CompressedHitWriter::ParseCodec(const G4String& name, Codec& codec)
+{
+  if (name == "zstd") {
+    codec = Codec::zstd;
+    return true;
+  }
+  if (name == "lz4") {
+    codec = Codec::lz4;
+    return true;
+  }
+  if (name == "none") {
+    codec = Codec::none;
+    return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompressedHitWriter::CompressedHitWriter(const G4String& fileName, Codec codec, G4int level,
+                                         const G4String& particle, std::size_t recordsPerBlock)
+  : fCodec(codec), fLevel(level), fRecordsPerBlock(recordsPerBlock)
+{
+  if (!IsAvailable(codec)) {
+    G4cerr << "[CompressedHitWriter] Warning: codec not available in this build, writing "
+           << "uncompressed blocks to " << fileName << G4endl;
+    fCodec = Codec::none;
+  }
+
+  fOut.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!fOut.is_open()) return;
+
+  fOut.write("B4CH", 4);
+  PutU32(fOut, kFormatVersion);
+  PutU32(fOut, static_cast<std::uint32_t>(fCodec));
+  std::string header = std::string(kHeaderLine) + "Particle=" + particle + "\nVolume=Detector\n";
+  PutU32(fOut, static_cast<std::uint32_t>(header.size()));
+  fOut.write(header.data(), header.size());
+
+  // Worst case is ~2 bytes per varint plus the two floats, reserve generously
+  fRaw.reserve(fRecordsPerBlock * 16);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompressedHitWriter::~CompressedHitWriter()
+{
+  if (fOut.is_open()) {
+    FlushBlock();
+    fOut.close();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompressedHitWriter::FlushBlock()
+{
+  if (fNofRecords == 0 || !fOut.is_open()) return;
+
+  std::size_t compressedSize = 0;
+  switch (fCodec) {
+    case Codec::none:
+      compressedSize = fRaw.size();
+      break;
+    case Codec::zstd:
+#ifdef B4C_HAVE_ZSTD
+      fCompressed.resize(ZSTD_compressBound(fRaw.size()));
+      compressedSize =
+        ZSTD_compress(fCompressed.data(), fCompressed.size(), fRaw.data(), fRaw.size(), fLevel);
+      if (ZSTD_isError(compressedSize)) compressedSize = 0;
+#endif
+      break;
+    case Codec::lz4:
+#ifdef B4C_HAVE_LZ4
+      fCompressed.resize(LZ4_compressBound(static_cast<int>(fRaw.size())));
+      compressedSize = LZ4_compress_default(fRaw.data(), fCompressed.data(),
+                                            static_cast<int>(fRaw.size()),
+                                            static_cast<int>(fCompressed.size()));
+#endif
+      break;
+  }
+  const char* payload = (fCodec == Codec::none) ? fRaw.data() : fCompressed.data();
+
+  if (compressedSize == 0) {
+    G4cerr << "[CompressedHitWriter] Warning: compression failed, dropping " << fNofRecords
+           << " records" << G4endl;
+  }
+  else {
+    fOut.write("BLK1", 4);
+    PutU32(fOut, fNofRecords);
+    PutU32(fOut, static_cast<std::uint32_t>(fRaw.size()));
+    PutU32(fOut, static_cast<std::uint32_t>(compressedSize));
+    PutU32(fOut, static_cast<std::uint32_t>(fFirstEventID));
+    fOut.write(payload, compressedSize);
+  }
+
+  fRaw.clear();
+  fNofRecords = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -1,24 +1,69 @@
 #include "DetectorConstruction.hh"
-#include "CalorimeterSD.hh"
+#include "PhotonOrigin.hh"
+#include "ScoringParallelWorld.hh"
 
 
 #include "G4Box.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4NistManager.hh"
-#include "G4SDManager.hh"
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4UserLimits.hh"
+#include "G4RegionStore.hh"
+#include "G4Region.hh"
 
 
 #include <fstream>
+#include <map>
 #include <sstream>
 
 
 namespace B4c {
 
 
+namespace {
+
+
+// Layer materials are NIST names with or without the G4_ prefix; common
+// compounds can be given by their formula
+G4Material* FindLayerMaterial(const G4String& name)
+{
+   static const std::map<G4String, G4String> aliases = {
+       {"B4C", "G4_BORON_CARBIDE"},
+       {"PE", "G4_POLYETHYLENE"},
+       {"Water", "G4_WATER"},
+   };
+
+   auto nist = G4NistManager::Instance();
+   auto alias = aliases.find(name);
+   if (alias != aliases.end()) return nist->FindOrBuildMaterial(alias->second);
+   if (name.rfind("G4_", 0) == 0) return nist->FindOrBuildMaterial(name);
+   return nist->FindOrBuildMaterial("G4_" + name);
+}
+
+
+// Thickness as in the binned CSV columns: 0.1, 0.25, 1.0
+G4String ThicknessLabel(G4double thicknessMM)
+{
+   std::ostringstream thickness;
+   thickness << thicknessMM;
+   G4String label = thickness.str();
+   if (label.find('.') == G4String::npos) label += ".0";
+   return label;
+}
+
+
+} // namespace
+
+
+DetectorConstruction::DetectorConstruction()
+{
+   RegisterParallelWorld(new ScoringParallelWorld(this));
+}
+
+
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
    G4bool checkOverlaps = true;
@@ -27,6 +72,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
    std::string materialName = "G4_W";
    G4double foilThickness = 0.1 * mm;
+   std::vector<std::pair<G4String, G4double>> stack;  // "layer" lines, in order
 
 
    std::ifstream infile("geometry.txt");
@@ -56,6 +102,70 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
                           << line << G4endl;
                }
            }
+           else if (key == "layer") {
+               std::string mat;
+               double val = -1.0;
+               if (iss >> mat >> val && val > 0.) {
+                   stack.emplace_back(mat, val * mm);
+               } else {
+                   G4cerr << "[DetectorConstruction] Could not read layer (material thickness_mm) "
+                          << "from line: " << line << G4endl;
+               }
+           }
+           else if (key == "score_emin" || key == "score_emax") {
+               double val = -1.0;
+               if (iss >> val && val >= 0.) {
+                   (key == "score_emin" ? fScoreEminMeV : fScoreEmaxMeV) = val;
+               } else {
+                   G4cerr << "[DetectorConstruction] Could not read scoring energy (MeV) from line: "
+                          << line << G4endl;
+               }
+           }
+           else if (key == "score") {
+               std::string val;
+               if (iss >> val && (val == "gamma" || val == "charged")) {
+                   fScoredParticles = val;
+               } else {
+                   G4cerr << "[DetectorConstruction] Score must be gamma or charged: "
+                          << line << G4endl;
+               }
+           }
+           else if (key == "spectra") {
+               std::string val;
+               if (iss >> val && (val == "on" || val == "off")) {
+                   fSpectraEnabled = (val == "on");
+               } else {
+                   G4cerr << "[DetectorConstruction] Spectra must be on or off: "
+                          << line << G4endl;
+               }
+           }
+           else if (key == "output") {
+               std::string val;
+               if (iss >> val && (val == "csv" || val == "compressed" || val == "none")) {
+                   fOutputFormat = val;
+               } else {
+                   G4cerr << "[DetectorConstruction] Output must be csv, compressed or none: "
+                          << line << G4endl;
+               }
+           }
+           else if (key == "codec") {
+               std::string val;
+               if (iss >> val) {
+                   fOutputCodec = val;
+               } else {
+                   G4cerr << "[DetectorConstruction] Could not read codec from line: "
+                          << line << G4endl;
+               }
+           }
+           else if (key == "compression_level") {
+               int val = 0;
+               if (iss >> val) {
+                   fCompressionLevel = val;
+               } else {
+                   G4cerr << "[DetectorConstruction] Could not read compression level from line: "
+                          << line << G4endl;
+               }
+           }
        }
        infile.close();
    }
@@ -64,39 +174,93 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
    }
 
 
-   if (foilThickness <= 0.) {
-       G4cerr << "[DetectorConstruction] Invalid foil thickness. Resetting to 0.1 mm." << G4endl;
-       foilThickness = 0.1 * mm;
+   // Without "layer" lines the stack is the single material/thickness foil
+   if (stack.empty()) {
+       if (foilThickness <= 0.) {
+           G4cerr << "[DetectorConstruction] Invalid foil thickness. Resetting to 0.1 mm." << G4endl;
+           foilThickness = 0.1 * mm;
+       }
+       stack.emplace_back(materialName, foilThickness);
+   }
+   if (stack.size() > kMaxLayers) {
+       G4cerr << "[DetectorConstruction] Only the first " << kMaxLayers << " layers are built."
+              << G4endl;
+       stack.resize(kMaxLayers);
    }
 
 
-   G4cout << "[DetectorConstruction] Material: " << materialName
-          << ", thickness: " << foilThickness / mm << " mm" << G4endl;
+   fLayers.clear();
+   for (const auto& [name, thickness] : stack) {
+       G4Material* mat = FindLayerMaterial(name);
+       G4String shortName = name;
+       if (!mat) {
+           G4cerr << "Material " << name << " not found. Using default G4_W." << G4endl;
+           mat = G4NistManager::Instance()->FindOrBuildMaterial("G4_W");
+           shortName = "W";
+       }
+       if (shortName.rfind("G4_", 0) == 0) shortName = shortName.substr(3);
 
+       Layer layer;
+       layer.material = mat;
+       layer.label = shortName + "_" + ThicknessLabel(thickness / mm) + "mm";
+       layer.thickness = thickness;
+       fLayers.push_back(layer);
 
-   G4Material* foilMat = nist->FindOrBuildMaterial(materialName);
-   if (!foilMat) {
-       G4cerr << "Material " << materialName << " not found. Using default G4_W." << G4endl;
-       foilMat = nist->FindOrBuildMaterial("G4_W");
-       materialName = "G4_W";
+       G4cout << "[DetectorConstruction] Layer " << fLayers.size() - 1 << ": "
+              << mat->GetName() << ", thickness: " << thickness / mm << " mm" << G4endl;
    }
 
 
-   fMaterialName = materialName;
-   fThicknessMM = foilThickness / mm;
+   fMaterialName = fLayers.front().material->GetName();
+   fThicknessMM = fLayers.front().thickness / mm;
 
 
+   // File names: the single-foil names stay as they were, so the plotting
+   // scripts keep working; a stack joins its layers with '+'
    std::ostringstream filename;
-   filename << "data/loweroutput_"
-            << fMaterialName
-            << "_"
-            << fThicknessMM
-            << "mm.txt";
+   std::ostringstream stackName;
+   filename << "data/loweroutput_";
+   for (std::size_t i = 0; i < fLayers.size(); ++i) {
+       if (i > 0) {
+           filename << "+";
+           stackName << "+";
+       }
+       filename << fLayers[i].material->GetName() << "_" << fLayers[i].thickness / mm << "mm";
+       stackName << fLayers[i].label;
+   }
+   filename << ".txt";
 
 
    fOutputFileName = filename.str();
 
 
+   // Native spectra, one per interface, labelled like the columns of
+   // binned_<material>.csv: W_0.1mm, W_0.1mm+B4C_5.0mm, ...
+   fSpectrumLabels.clear();
+   G4String label;
+   for (const auto& layer : fLayers) {
+       label += (label.empty() ? "" : "+") + layer.label;
+       fSpectrumLabels.push_back(label);
+   }
+
+   G4String spectrumStem = (fLayers.size() == 1)
+       ? fMaterialName + "_" + ThicknessLabel(fThicknessMM) + "mm"
+       : G4String(stackName.str());
+   fSpectrumFileName = "data/spectrum_" + spectrumStem + ".csv";
+
+
+   // Same spectra split by how the photon was made; a separate file, so
+   // readers of the spectrum files are not affected
+   fOriginSpectrumFileName = "data/origins_" + spectrumStem + ".csv";
+   fOriginSpectrumLabels.clear();
+   for (const auto& planeLabel : fSpectrumLabels)
+       for (G4int origin = 0; origin < kNofPhotonOrigins; ++origin)
+           fOriginSpectrumLabels.push_back(planeLabel + "_" + PhotonOriginLabel(origin));
+
+   // Next-event estimate of the fluence at the point detectors, if any
+   fPointDetectorFileName = "data/pointdet_" + spectrumStem + ".csv";
+
+
    G4cout << "[DetectorConstruction] Output file: "
           << fOutputFileName << G4endl;
 
@@ -109,53 +273,54 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
        nullptr, G4ThreeVector(), logicWorld, "World", nullptr, false, 0, checkOverlaps);
 
 
-   // Target
-   auto solidTarget = new G4Box("Target", 0.5 * cm, 0.5 * cm, foilThickness / 2.0);
-   logicTarget = new G4LogicalVolume(solidTarget, foilMat, "Target");
-
-
+   // Stack along z. The first layer is centred on the origin as the single
+   // foil always was and the next layer starts right at its back face; the
+   // scoring planes on the interfaces are in the parallel world
+   // (ScoringParallelWorld).
    auto targetVis = new G4VisAttributes(G4Colour(0.8, 0.5, 0.2));
    targetVis->SetVisibility(true);
-   logicTarget->SetVisAttributes(targetVis);
-
-
-   new G4PVPlacement(
-       nullptr, G4ThreeVector(), logicTarget, "Target", logicWorld, false, 0, checkOverlaps);
 
+   G4double zFront = -fLayers.front().thickness / 2.0;
+   for (std::size_t i = 0; i < fLayers.size(); ++i) {
+       auto& layer = fLayers[i];
+       G4String name = (i == 0) ? G4String("Target") : "Layer" + std::to_string(i);
 
-   fTargetBackZ = foilThickness / 2.0;
-   fBremsVolume = logicTarget;
-
+       auto solidLayer = new G4Box(name, 0.5 * cm, 0.5 * cm, layer.thickness / 2.0);
+       layer.logical = new G4LogicalVolume(solidLayer, layer.material, name);
+       layer.logical->SetVisAttributes(targetVis);
+       layer.zFront = zFront;
+       layer.zBack = zFront + layer.thickness;
 
-   // Thin detector plane behind foil (can stay for visualization, but not sensitive)
-   G4double detectorXY = 2.0 * cm;
-   G4double detectorThicknessZ = 1.0 * um;
+       new G4PVPlacement(
+           nullptr, G4ThreeVector(0, 0, zFront + layer.thickness / 2.0), layer.logical, name,
+           logicWorld, false, 0, checkOverlaps);
 
+       // Each layer is its own region, named like the layer, so that weight
+       // windows (/B4c/ww/window) can differ per layer. The regions have no
+       // production cuts of their own and use the default ones.
+       G4RegionStore::GetInstance()->FindOrCreateRegion(name)->AddRootLogicalVolume(layer.logical);
 
-   auto solidDetector = new G4Box(
-       "Detector",
-       detectorXY / 2.0,
-       detectorXY / 2.0,
-       detectorThicknessZ / 2.0);
-
+       zFront = layer.zBack;
+   }
 
-   logicDetector = new G4LogicalVolume(solidDetector, worldMat, "Detector");
 
+   logicTarget = fLayers.front().logical;
+   fBremsVolume = logicTarget;
 
-   auto detectorVis = new G4VisAttributes(G4Colour(0., 0., 1., 0.3));
-   detectorVis->SetForceSolid(true);
-   logicDetector->SetVisAttributes(detectorVis);
 
+   // Photons and electrons below the scoring window can never put a photon
+   // into it, so they are stopped as soon as they fall below it
+   // (G4UserSpecialCuts, see ScoringWindowPhysics)
+   if (fScoreEminMeV > 0.) {
+       auto limits = new G4UserLimits(DBL_MAX, DBL_MAX, DBL_MAX, fScoreEminMeV * MeV);
+       logicWorld->SetUserLimits(limits);
+       for (auto& layer : fLayers)
+           layer.logical->SetUserLimits(limits);
 
-   new G4PVPlacement(
-       nullptr,
-       G4ThreeVector(0, 0, fTargetBackZ + detectorThicknessZ / 2.0),
-       logicDetector,
-       "Detector",
-       logicWorld,
-       false,
-       1,
-       checkOverlaps);
+       G4cout << "[DetectorConstruction] Scoring window " << fScoreEminMeV << " - "
+              << fScoreEmaxMeV << " MeV, photons and electrons below "
+              << fScoreEminMeV << " MeV are stopped" << G4endl;
+   }
 
 
    logicWorld->SetVisAttributes(G4VisAttributes::GetInvisible());
@@ -165,14 +330,4 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 }
 
 
-void DetectorConstruction::ConstructSDandField()
-{
-   auto calorSD = new CalorimeterSD("DetectorSD", "CalorHitsCollection", 1);
-   G4SDManager::GetSDMpointer()->AddNewDetector(calorSD);
-
-   // Make the thin detector plane behind the foil sensitive
-   logicDetector->SetSensitiveDetector(calorSD);
-}
-
-
 } // namespace B4c
\ No newline at end of file
@@ -4,9 +4,16 @@
 
 #include "EventAction.hh"
 
+#include "PointDetectorEstimator.hh"
+#include "TracingSteppingAction.hh"
+
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4VVisManager.hh"
 
 #include <iomanip>
 
@@ -15,13 +22,44 @@ namespace B4c
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-EventAction::EventAction() : G4UserEventAction() {}
+EventAction::EventAction() : G4UserEventAction()
+{
+  fMessenger = std::make_unique<G4GenericMessenger>(this, "/B4c/vis/", "Event sampling for vis");
+  fMessenger->DeclareProperty("drawEvery", fDrawEvery, "Draw one event in N per thread")
+    .SetParameterName("N", false)
+    .SetRange("N >= 1");
+  fMessenger
+    ->DeclareProperty("maxEvents", fMaxDrawnEvents, "Maximum drawn events per thread and run")
+    .SetParameterName("max", false)
+    .SetRange("max >= 0");
+}
 
 EventAction::~EventAction() {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::BeginOfEventAction(const G4Event* /*event*/) {}
+void EventAction::BeginOfEventAction(const G4Event* event)
+{
+  // Event traces select their events here, with or without visualization
+  EventTracer::Instance().BeginOfEvent(event->GetEventID());
+
+  // Nothing to sample without visualization (batch mode)
+  if (!G4VVisManager::GetConcreteInstance()) return;
+
+  auto runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if (runID != fLastRunID) {
+    fLastRunID = runID;
+    fNofEvents = 0;
+    fNofDrawnEvents = 0;
+  }
+
+  auto trackingManager = G4EventManager::GetEventManager()->GetTrackingManager();
+  if (fStoreTrajectory < 0) fStoreTrajectory = trackingManager->GetStoreTrajectory();
+
+  // Counted per thread: the event IDs a worker gets depend on scheduling
+  fDrawThisEvent = (fNofEvents++ % fDrawEvery == 0) && (fNofDrawnEvents < fMaxDrawnEvents);
+  trackingManager->SetStoreTrajectory(fDrawThisEvent ? fStoreTrajectory : 0);
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -34,6 +72,19 @@ void EventAction::EndOfEventAction(const G4Event* event)
     G4cout << "--> End of event: " << eventID << "\n" << G4endl;
   }
 
+  // Hand the sampled event to the vis manager
+  if (fDrawThisEvent) {
+    G4EventManager::GetEventManager()->KeepTheCurrentEvent();
+    ++fNofDrawnEvents;
+    fDrawThisEvent = false;
+  }
+
+  // Point-detector estimates of this event
+  PointDetectorStore::Instance().EndOfEvent();
+
+  // Keep or drop the traced steps of this event
+  EventTracer::Instance().EndOfEvent();
+
   // Later add custom scoring or analysis, do it here
   auto analysisManager = G4AnalysisManager::Instance();
   // Example placeholder:
@@ -0,0 +1,73 @@
+/// \file B4/B4c/src/PhotonOrigin.cc
+/// \brief Implementation of the B4c::PhotonOriginClassifier class
+
+#include "PhotonOrigin.hh"
+
+#include "TrackInformation.hh"
+
+#include "G4EmProcessSubType.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* PhotonOriginLabel(G4int origin)
+{
+  switch (origin) {
+    case kBremsstrahlung: return "brems";
+    case kFluorescence: return "fluo";
+    case kAnnihilation: return "annihil";
+    default: return "other";
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PhotonOriginClassifier::Classify(const G4Track& track)
+{
+  auto* info = static_cast<const TrackInformation*>(track.GetUserInformation());
+  if (info && info->GetOrigin() >= 0) return info->GetOrigin();
+
+  // Consecutive photons mostly come from the same process
+  const G4VProcess* creator = track.GetCreatorProcess();
+  if (creator == fLastProcess) return fLastOrigin;
+
+  fLastProcess = creator;
+  for (const auto& [process, origin] : fCache) {
+    if (process == creator) return fLastOrigin = origin;
+  }
+  fLastOrigin = FromProcess(creator);
+  fCache.emplace_back(creator, fLastOrigin);
+  return fLastOrigin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PhotonOriginClassifier::FromProcess(const G4VProcess* process)
+{
+  if (!process || process->GetProcessType() != fElectromagnetic) return kOtherOrigin;
+
+  switch (process->GetProcessSubType()) {
+    case fBremsstrahlung:
+      return kBremsstrahlung;
+    case fAnnihilation:
+      return kAnnihilation;
+    // These processes only emit photons through atomic de-excitation. The
+    // gamma general process reports its selected sub-process as creator,
+    // it is listed in case a version does not.
+    case fPhotoElectricEffect:
+    case fComptonScattering:
+    case fIonisation:
+    case fGammaGeneralProcess:
+      return kFluorescence;
+    default:
+      return kOtherOrigin;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
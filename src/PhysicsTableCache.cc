@@ -0,0 +1,160 @@
+/// \file B4/B4c/src/PhysicsTableCache.cc
+/// \brief Implementation of the B4c::PhysicsTableCache class
+
+#include "PhysicsTableCache.hh"
+
+#include "G4Material.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4StateManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UserLimits.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4VPhysicsConstructor.hh"
+#include "G4Version.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace B4c
+{
+
+namespace
+{
+// Marker written after a successful store; its content is the full key
+const char* kKeyFile = "cache_key.txt";
+
+// FNV-1a, so the directory name is stable across compilers and runs
+std::uint64_t Fnv1a(const std::string& text)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhysicsTableCache::PhysicsTableCache(G4VModularPhysicsList* physicsList,
+                                     const G4String& physicsListName,
+                                     const G4String& baseDirectory)
+  : fPhysicsList(physicsList), fPhysicsListName(physicsListName), fBaseDirectory(baseDirectory)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsTableCache::ComputeKey() const
+{
+  std::ostringstream key;
+  key << "physics_list " << fPhysicsListName << "\n";
+  key << "geant4 " << G4VERSION_NUMBER << "\n";
+
+  // Registration order matters for the processes, so it is kept
+  for (G4int i = 0; fPhysicsList->GetPhysics(i) != nullptr; ++i) {
+    key << "constructor " << fPhysicsList->GetPhysics(i)->GetPhysicsName() << "\n";
+  }
+
+  auto defaultCuts = G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts();
+  key << std::setprecision(9);
+  for (const char* particle : {"gamma", "e-", "e+", "proton"}) {
+    key << "cut " << particle << " " << defaultCuts->GetProductionCut(particle) / mm << " mm\n";
+  }
+
+  // Regions without their own cuts use the default ones above
+  std::vector<std::string> regions;
+  for (const auto* region : *G4RegionStore::GetInstance()) {
+    std::ostringstream line;
+    line << std::setprecision(9) << "region " << region->GetName();
+    if (const auto* cuts = region->GetProductionCuts()) {
+      for (const char* particle : {"gamma", "e-", "e+", "proton"}) {
+        line << " " << particle << " " << cuts->GetProductionCut(particle) / mm << " mm";
+      }
+    }
+    if (const auto* limits = region->GetUserLimits()) {
+      line << " limits " << limits->GetType();
+    }
+    regions.push_back(line.str());
+  }
+  std::sort(regions.begin(), regions.end());
+  for (const auto& region : regions) {
+    key << region << "\n";
+  }
+
+  std::vector<std::string> materials;
+  for (const auto* material : *G4Material::GetMaterialTable()) {
+    materials.push_back(material->GetName());
+  }
+  std::sort(materials.begin(), materials.end());
+  for (const auto& name : materials) {
+    key << "material " << name << "\n";
+  }
+
+  return key.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhysicsTableCache::Notify(G4ApplicationState requestedState)
+{
+  auto previousState = G4StateManager::GetStateManager()->GetPreviousState();
+
+  // Idle -> Init: the kernel is about to build the tables for a run
+  if (previousState == G4State_Idle && requestedState == G4State_Init) {
+    fKey = ComputeKey();
+    std::ostringstream dir;
+    dir << fBaseDirectory << "/" << fPhysicsListName << "_" << std::hex << Fnv1a(fKey);
+    fDirectory = dir.str();
+
+    std::ifstream marker(fDirectory + "/" + kKeyFile);
+    std::stringstream stored;
+    stored << marker.rdbuf();
+
+    if (marker.is_open() && stored.str() == fKey) {
+      fPhysicsList->SetPhysicsTableRetrieved(fDirectory);
+      fStorePending = false;
+      G4cout << "[PhysicsTableCache] Retrieving physics tables from " << fDirectory << G4endl;
+    }
+    else {
+      fPhysicsList->ResetPhysicsTableRetrieved();
+      fStorePending = true;
+      G4cout << "[PhysicsTableCache] No cached tables for this configuration, building"
+             << G4endl;
+    }
+  }
+  // Tables are built once the geometry is closed for the run
+  else if (requestedState == G4State_GeomClosed && fStorePending) {
+    fStorePending = false;
+    std::error_code ec;
+    std::filesystem::create_directories(fDirectory, ec);
+    if (ec) {
+      G4cerr << "[PhysicsTableCache] Warning: could not create " << fDirectory << ": "
+             << ec.message() << G4endl;
+      return true;
+    }
+    if (fPhysicsList->StorePhysicsTable(fDirectory)) {
+      std::ofstream marker(fDirectory + "/" + kKeyFile, std::ios::out | std::ios::trunc);
+      marker << fKey;
+      G4cout << "[PhysicsTableCache] Stored physics tables in " << fDirectory << G4endl;
+    }
+    else {
+      G4cerr << "[PhysicsTableCache] Warning: storing physics tables in " << fDirectory
+             << " failed" << G4endl;
+    }
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -0,0 +1,344 @@
+/// \file B4/B4c/src/PointDetectorEstimator.cc
+/// \brief Implementation of the B4c::PointDetectorEstimator and B4c::PointDetectorStore classes
+
+#include "PointDetectorEstimator.hh"
+
+#include "DetectorConstruction.hh"
+#include "SpectrumRegistry.hh"
+#include "ThreadSteppingActions.hh"
+
+#include "G4EmProcessSubType.hh"
+#include "G4Exp.hh"
+#include "G4Gamma.hh"
+#include "G4GammaGeneralProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4TransportationManager.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIdirectory.hh"
+#include "G4UnitsTable.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4c
+{
+
+namespace
+{
+// The estimator of this worker thread, owned by its stepping manager
+G4ThreadLocal PointDetectorEstimator* threadEstimator = nullptr;
+
+// Attenuation table grid: 1 keV - 100 MeV, 50 points per decade
+constexpr G4double kTableEmin = 1. * keV;
+constexpr G4int kPointsPerDecade = 50;
+constexpr G4int kNofTablePoints = 5 * kPointsPerDecade + 1;
+
+// Contributions behind more mean free paths than this are dropped
+constexpr G4double kMaxOpticalDepth = 50.;
+
+// Emission density per steradian of the G4ModifiedTsai bremsstrahlung
+// angular distribution: u follows 1/4 Gamma(2, a1) + 3/4 Gamma(2, a2)
+// below uMax, and cos(theta) = 1 - 2 u^2 / uMax^2
+G4double TsaiDensity(G4double electronEnergy, G4double cosTheta)
+{
+  constexpr G4double a1 = 1.6;
+  constexpr G4double a2 = a1 / 3.;
+  G4double uMax = 2. * (1. + electronEnergy / electron_mass_c2);
+  G4double u = uMax * std::sqrt(std::max(0., 0.5 * (1. - cosTheta)));
+
+  auto gammaCDF = [](G4double x) { return 1. - G4Exp(-x) * (1. + x); };
+  G4double norm = 0.25 * gammaCDF(uMax / a1) + 0.75 * gammaCDF(uMax / a2);
+  G4double densityOverU = 0.25 * G4Exp(-u / a1) / (a1 * a1) + 0.75 * G4Exp(-u / a2) / (a2 * a2);
+
+  // d cos(theta) = 4 u du / uMax^2, d Omega = 2 pi d cos(theta)
+  return densityOverU * uMax * uMax / (4. * norm * twopi);
+}
+
+// Klein-Nishina density per steradian, and the scattered photon energy
+G4double KleinNishinaDensity(G4double energy, G4double cosTheta, G4double& scattered)
+{
+  G4double k = energy / electron_mass_c2;
+  G4double ratio = 1. / (1. + k * (1. - cosTheta));  // E' / E
+  scattered = energy * ratio;
+
+  // Both in units of r_e^2
+  G4double dSigma = 0.5 * ratio * ratio * (ratio + 1. / ratio - (1. - cosTheta * cosTheta));
+  G4double l = std::log(1. + 2. * k);
+  G4double sigma = twopi
+                   * ((1. + k) / (k * k) * (2. * (1. + k) / (1. + 2. * k) - l / k)
+                      + l / (2. * k) - (1. + 3. * k) / ((1. + 2. * k) * (1. + 2. * k)));
+  return dSigma / sigma;
+}
+
+G4bool IsComptonScattering(const G4VProcess* process)
+{
+  if (!process) return false;
+  if (process->GetProcessSubType() == fComptonScattering) return true;
+  return process->GetProcessSubType() == fGammaGeneralProcess
+         && static_cast<const G4GammaGeneralProcess*>(process)->GetSubProcessSubType()
+              == fComptonScattering;
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PointDetectorEstimator::PointDetectorEstimator()
+{
+  fGamma = G4Gamma::Definition();
+
+  auto detConst = static_cast<const DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  fScoreEmin = detConst->GetScoreEminMeV() * MeV;
+  fScoreEmax = detConst->GetScoreEmaxMeV() * MeV;
+
+  // Rays are traced in this thread's mass world
+  fNavigator = std::make_unique<G4Navigator>();
+  fNavigator->SetWorldVolume(G4TransportationManager::GetTransportationManager()
+                               ->GetNavigatorForTracking()
+                               ->GetWorldVolume());
+}
+
+PointDetectorEstimator::~PointDetectorEstimator() = default;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetectorEstimator::SetDetectors(const std::vector<G4ThreeVector>& detectors)
+{
+  fDetectors = detectors;
+  auto& registry = SpectrumRegistry::Instance();
+  for (auto i = static_cast<G4int>(fSpectra.size()); i < static_cast<G4int>(fDetectors.size());
+       ++i)
+    fSpectra.push_back(registry.CreateThreadSpectrum(PointDetectorSpectrumKey(i)));
+}
+
+void PointDetectorEstimator::EndOfEvent()
+{
+  for (auto* spectrum : fSpectra)
+    spectrum->EndOfEvent();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetectorEstimator::UserSteppingAction(const G4Step* step)
+{
+  if (fDetectors.empty()) return;
+
+  const auto* preStep = step->GetPreStepPoint();
+  const auto* postStep = step->GetPostStepPoint();
+
+  // Photons emitted in this step
+  for (const G4Track* secondary : *step->GetSecondaryInCurrentStep()) {
+    if (secondary->GetDefinition() != fGamma) continue;
+
+    // Copies made by the weight windows are not new photons
+    const G4VProcess* creator = secondary->GetCreatorProcess();
+    if (creator && creator->GetProcessType() == fGeneral) continue;
+
+    G4double energy = secondary->GetKineticEnergy();
+    if (energy < fScoreEmin || energy > fScoreEmax) continue;
+
+    // Bremsstrahlung is peaked along the electron direction at the
+    // emission, p_e(post) + p_gamma: the pre-step direction misses the
+    // multiple scattering along the step, which in a thick foil turns the
+    // electron before the emission. Everything else is taken as isotropic
+    G4bool brems = fOriginClassifier.Classify(*secondary) == kBremsstrahlung;
+    G4double electronEnergy = postStep->GetKineticEnergy() + energy;
+    G4ThreeVector electronDirection = (postStep->GetMomentum() + secondary->GetMomentum()).unit();
+    const G4ThreeVector& site = secondary->GetPosition();
+    for (std::size_t i = 0; i < fDetectors.size(); ++i) {
+      G4ThreeVector toDetector = fDetectors[i] - site;
+      G4double distance = toDetector.mag();
+      G4ThreeVector direction = toDetector / distance;
+      G4double density =
+        brems ? TsaiDensity(electronEnergy, electronDirection.dot(direction))
+              : 1. / (4. * pi);
+      Contribute(site, energy, secondary->GetWeight() * density, i, distance, direction);
+    }
+  }
+
+  // Compton scattering: the photon itself goes on from here
+  const G4Track* track = step->GetTrack();
+  if (track->GetDefinition() != fGamma || !IsComptonScattering(postStep->GetProcessDefinedStep()))
+    return;
+
+  G4double energy = preStep->GetKineticEnergy();
+  const G4ThreeVector& site = postStep->GetPosition();
+  for (std::size_t i = 0; i < fDetectors.size(); ++i) {
+    G4ThreeVector toDetector = fDetectors[i] - site;
+    G4double distance = toDetector.mag();
+    G4ThreeVector direction = toDetector / distance;
+    G4double scattered = 0.;
+    G4double density =
+      KleinNishinaDensity(energy, preStep->GetMomentumDirection().dot(direction), scattered);
+    if (scattered < fScoreEmin || scattered > fScoreEmax) continue;
+    Contribute(site, scattered, preStep->GetWeight() * density, i, distance, direction);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetectorEstimator::Contribute(const G4ThreeVector& site, G4double energy,
+                                        G4double weightPerSr, std::size_t detector,
+                                        G4double distance, const G4ThreeVector& direction)
+{
+  if (weightPerSr <= 0.) return;
+  G4double depth = OpticalDepth(site, direction, distance, energy);
+  if (depth > kMaxOpticalDepth) return;
+  fSpectra[detector]->Fill(energy / MeV, weightPerSr * G4Exp(-depth) * cm2 / (distance * distance));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PointDetectorEstimator::OpticalDepth(const G4ThreeVector& site,
+                                              const G4ThreeVector& direction,
+                                              G4double distance, G4double energy)
+{
+  G4ThreeVector point = site;
+  G4double remaining = distance;
+  G4double depth = 0.;
+
+  // Outside the world there is only vacuum
+  G4VPhysicalVolume* volume = fNavigator->LocateGlobalPointAndSetup(point, &direction, false);
+  for (G4int crossings = 0; volume && remaining > 0. && crossings < 1000; ++crossings) {
+    G4double safety = 0.;
+    G4double length = std::min(remaining, fNavigator->ComputeStep(point, direction, remaining,
+                                                                  safety));
+    depth += AttenuationCoefficient(volume->GetLogicalVolume()->GetMaterial(), energy) * length;
+    if (depth > kMaxOpticalDepth) break;
+
+    remaining -= length;
+    point += length * direction;
+    fNavigator->SetGeometricallyLimitedStep();
+    volume = fNavigator->LocateGlobalPointAndSetup(point, &direction, true);
+  }
+  return depth;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PointDetectorEstimator::AttenuationCoefficient(const G4Material* material,
+                                                        G4double energy)
+{
+  if (material != fLastMaterial) {
+    auto& table = fAttenuation[material];
+    if (table.empty()) {
+      // Total mu (photoelectric, Compton, pair, Rayleigh) of the physics list
+      table.resize(kNofTablePoints);
+      for (G4int i = 0; i < kNofTablePoints; ++i) {
+        G4double e = kTableEmin * std::pow(10., static_cast<G4double>(i) / kPointsPerDecade);
+        G4double length = fEmCalculator.ComputeGammaAttenuationLength(e, material);
+        table[i] = (length > 0. && length < DBL_MAX) ? 1. / length : 0.;
+      }
+    }
+    fLastMaterial = material;
+    fLastAttenuation = &table;
+  }
+
+  // Linear in log(E); edges are smeared over one grid step (~5 %)
+  G4double x = std::log10(energy / kTableEmin) * kPointsPerDecade;
+  x = std::clamp(x, 0., kNofTablePoints - 1.001);
+  auto i = static_cast<G4int>(x);
+  G4double f = x - i;
+  return (1. - f) * (*fLastAttenuation)[i] + f * (*fLastAttenuation)[i + 1];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PointDetectorStore& PointDetectorStore::Instance()
+{
+  static PointDetectorStore instance;
+  return instance;
+}
+
+PointDetectorStore::PointDetectorStore()
+{
+  fDirectory = std::make_unique<G4UIdirectory>("/B4c/ned/", false);
+  fDirectory->SetGuidance("Next-event estimator: photon fluence at point detectors");
+
+  fDetectorCmd = std::make_unique<G4UIcmdWith3VectorAndUnit>("/B4c/ned/detector", this);
+  fDetectorCmd->SetGuidance("Add a point detector at the given position");
+  fDetectorCmd->SetParameterName("x", "y", "z", false);
+  fDetectorCmd->SetUnitCategory("Length");
+
+  fClearCmd = std::make_unique<G4UIcmdWithoutParameter>("/B4c/ned/clear", this);
+  fClearCmd->SetGuidance("Remove all point detectors");
+
+  fListCmd = std::make_unique<G4UIcmdWithoutParameter>("/B4c/ned/list", this);
+  fListCmd->SetGuidance("Print the point detectors");
+
+  // The list is shared: the master edits it, the workers only read it
+  for (G4UIcommand* command : {static_cast<G4UIcommand*>(fDetectorCmd.get()),
+                               static_cast<G4UIcommand*>(fClearCmd.get()),
+                               static_cast<G4UIcommand*>(fListCmd.get())})
+    command->SetToBeBroadcasted(false);
+}
+
+PointDetectorStore::~PointDetectorStore() = default;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetectorStore::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fDetectorCmd.get()) {
+    fDetectors.push_back(fDetectorCmd->GetNew3VectorValue(newValue));
+  }
+  else if (command == fClearCmd.get()) {
+    fDetectors.clear();
+  }
+  else if (command == fListCmd.get()) {
+    for (std::size_t i = 0; i < fDetectors.size(); ++i)
+      G4cout << "[PointDetectorStore] pd" << i << " at " << G4BestUnit(fDetectors[i], "Length")
+             << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetectorStore::BeginOfRun(G4bool isMaster)
+{
+  if (isMaster && G4Threading::IsMultithreadedApplication()) return;
+
+  // Register the estimator the first time detectors are defined
+  if (!threadEstimator && !fDetectors.empty()) {
+    threadEstimator = new PointDetectorEstimator();
+    AddThreadSteppingAction(threadEstimator);
+  }
+  if (threadEstimator) threadEstimator->SetDetectors(fDetectors);
+}
+
+void PointDetectorStore::EndOfEvent()
+{
+  if (threadEstimator) threadEstimator->EndOfEvent();
+}
+
+void PointDetectorStore::EndOfRun(G4bool isMaster)
+{
+  if (!isMaster || fDetectors.empty()) return;
+
+  auto detConst = static_cast<const DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  std::vector<G4String> labels;
+  for (std::size_t i = 0; i < fDetectors.size(); ++i)
+    labels.push_back("pd" + std::to_string(i));
+
+  const G4String& fileName = detConst->GetPointDetectorFileName();
+  if (SpectrumRegistry::Instance().WriteCSV(fileName, labels, kPointDetectorSpectrumKey)) {
+    G4cout << "[PointDetectorStore] Point-detector fluence written to " << fileName << G4endl;
+  }
+  else {
+    G4cerr << "[PointDetectorStore] Warning: could not write " << fileName << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
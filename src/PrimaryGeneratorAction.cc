@@ -14,12 +14,15 @@
 #include "G4SystemOfUnits.hh"
 #include "G4GeneralParticleSource.hh"
 #include "G4AnalysisManager.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4Threading.hh"
 
 #include "Randomize.hh"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 
 namespace B4
@@ -58,6 +61,21 @@ PrimaryGeneratorAction::PrimaryGeneratorAction()
     fCDF.push_back(cumulative);
   }
   fCDF.back() = 1.0; // ensure last bin catches rounding
+
+  // Importance sampling of the energy; commands are broadcast to the workers
+  fMessenger = std::make_unique<G4GenericMessenger>(this, "/B4c/gun/", "Primary energy biasing");
+  fMessenger
+    ->DeclareMethodWithUnit("tailEnergy", "MeV", &PrimaryGeneratorAction::SetTailEnergy,
+                            "Lower edge of the biased energy tail")
+    .SetParameterName("Et", false)
+    .SetRange("Et > 0.");
+  fMessenger
+    ->DeclareMethod("tailFraction", &PrimaryGeneratorAction::SetTailFraction,
+                    "Fraction of primaries drawn above tailEnergy (0 = unbiased)")
+    .SetParameterName("f", false)
+    .SetRange("f >= 0. && f < 1.");
+  fMessenger->DeclareMethod("importanceFile", &PrimaryGeneratorAction::SetImportanceFile,
+                            "Importance function, lines \"E_MeV importance\" (none = off)");
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
@@ -88,8 +106,111 @@ void PrimaryGeneratorAction::LoadSpectrum(const std::string& filename)
     G4cerr << "WARNING: No energy points found in spectrum file." << G4endl;
 }
 
-double PrimaryGeneratorAction::SampleEnergy() const
+void PrimaryGeneratorAction::SetTailEnergy(G4double energy)
+{
+  fTailEnergy = energy;
+  fBiasDirty = true;
+}
+
+void PrimaryGeneratorAction::SetTailFraction(G4double fraction)
+{
+  fTailFraction = fraction;
+  fBiasDirty = true;
+}
+
+void PrimaryGeneratorAction::SetImportanceFile(const G4String& fileName)
+{
+  fImportanceFile = (fileName == "none") ? G4String() : fileName;
+  fBiasDirty = true;
+}
+
+void PrimaryGeneratorAction::BuildBiasedSpectrum()
+{
+  fBiasDirty = false;
+  fBiasedCDF.clear();
+  fWeights.clear();
+  if (fEnergies.empty() || (fTailFraction <= 0. && fImportanceFile.empty())) return;
+
+  // Importance per spectrum point from the step function in the file
+  std::vector<double> importance(fEnergies.size(), 1.0);
+  if (!fImportanceFile.empty()) {
+    std::vector<std::pair<double, double>> steps;
+    std::ifstream infile(fImportanceFile);
+    std::string line;
+    while (std::getline(infile, line)) {
+      std::istringstream iss(line);
+      double E, I;
+      if (iss >> E >> I && I >= 0.) steps.emplace_back(E * MeV, I);
+    }
+    if (steps.empty()) {
+      G4cerr << "[PrimaryGeneratorAction] No importance values read from " << fImportanceFile
+             << ", primary energy stays unbiased" << G4endl;
+      return;
+    }
+    std::sort(steps.begin(), steps.end());
+    for (std::size_t i = 0; i < fEnergies.size(); ++i) {
+      auto it = std::upper_bound(steps.begin(), steps.end(), std::make_pair(fEnergies[i], 1e300));
+      importance[i] = (it == steps.begin()) ? steps.front().second : std::prev(it)->second;
+    }
+  }
+
+  // Unbiased probabilities p and importance-weighted ones
+  double total = std::accumulate(fProbabilities.begin(), fProbabilities.end(), 0.0);
+  std::vector<double> q(fEnergies.size());
+  double tailP = 0., tailQ = 0., sumQ = 0.;
+  for (std::size_t i = 0; i < fEnergies.size(); ++i) {
+    q[i] = fProbabilities[i] / total * importance[i];
+    sumQ += q[i];
+    if (fEnergies[i] >= fTailEnergy) {
+      tailP += fProbabilities[i] / total;
+      tailQ += q[i];
+    }
+  }
+  if (sumQ <= 0.) {
+    G4cerr << "[PrimaryGeneratorAction] Importance is zero everywhere, primary energy stays unbiased"
+           << G4endl;
+    return;
+  }
+
+  // Scale the tail so that it holds fTailFraction of the biased distribution
+  if (fTailFraction > 0.) {
+    if (tailQ <= 0. || tailQ >= sumQ) {
+      G4cerr << "[PrimaryGeneratorAction] No spectrum points on both sides of "
+             << fTailEnergy / MeV << " MeV, tail biasing ignored" << G4endl;
+    }
+    else {
+      double scale = fTailFraction * (sumQ - tailQ) / ((1. - fTailFraction) * tailQ);
+      for (std::size_t i = 0; i < fEnergies.size(); ++i)
+        if (fEnergies[i] >= fTailEnergy) q[i] *= scale;
+      sumQ += (scale - 1.) * tailQ;
+      tailQ *= scale;
+    }
+  }
+
+  // Points the importance excludes can never be drawn; their weight is unused
+  fBiasedCDF.reserve(q.size());
+  fWeights.reserve(q.size());
+  double cumulative = 0.0, meanWeight2 = 0.0;
+  for (std::size_t i = 0; i < q.size(); ++i) {
+    double p = fProbabilities[i] / total;
+    cumulative += q[i] / sumQ;
+    fBiasedCDF.push_back(cumulative);
+    fWeights.push_back(q[i] > 0. ? p * sumQ / q[i] : 0.);
+    if (q[i] > 0.) meanWeight2 += p * fWeights.back();
+  }
+  fBiasedCDF.back() = 1.0;
+
+  if (G4Threading::G4GetThreadId() <= 0) {
+    G4cout << "[PrimaryGeneratorAction] Biased primary energy: fraction above "
+           << fTailEnergy / MeV << " MeV " << tailP << " -> " << tailQ / sumQ
+           << ", <w^2> = " << meanWeight2 << G4endl;
+  }
+}
+
+double PrimaryGeneratorAction::SampleEnergy(G4double& weight) const
 {
+  weight = 1.;
+
   // Protect against empty spectrum
   if (fEnergies.empty() || fCDF.empty()) return 1.0 * MeV;
 
@@ -99,30 +220,44 @@ double PrimaryGeneratorAction::SampleEnergy() const
   // to low energies.
 
   // Build cumulative distribution once (fCDF is built in constructor)
+  const auto& cdf = fBiasedCDF.empty() ? fCDF : fBiasedCDF;
   double r = G4UniformRand();
 
   // Binary search for the bin
-  auto it = std::lower_bound(fCDF.begin(), fCDF.end(), r);
-  int index = static_cast<int>(std::distance(fCDF.begin(), it));
+  auto it = std::lower_bound(cdf.begin(), cdf.end(), r);
+  int index = static_cast<int>(std::distance(cdf.begin(), it));
   if (index >= static_cast<int>(fEnergies.size()))
     index = static_cast<int>(fEnergies.size()) - 1;
 
+  if (!fWeights.empty()) weight = fWeights[index];
   return fEnergies[index];
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* event)
 {
+  if (fBiasDirty) BuildBiasedSpectrum();
+
   // Sample an energy from the loaded spectrum
-  G4double sampledEnergy = SampleEnergy();
+  G4double weight = 1.;
+  G4double sampledEnergy = SampleEnergy(weight);
   fParticleGun->GetCurrentSource()->GetEneDist()->SetMonoEnergy(sampledEnergy);
 
   // Generate the event
   fParticleGun->GeneratePrimaryVertex(event);
 
+  // Tracks start with the vertex weight times the particle weight, and
+  // secondaries inherit it, so p/q reaches every scored photon
+  if (weight != 1.) {
+    for (G4int i = 0; i < event->GetNumberOfPrimaryVertex(); ++i) {
+      auto* vertex = event->GetPrimaryVertex(i);
+      vertex->SetWeight(vertex->GetWeight() * weight);
+    }
+  }
+
   // Optional: fill analysis histogram
   auto* analysisManager = G4AnalysisManager::Instance();
   if (analysisManager)
-    analysisManager->FillH1(0, sampledEnergy / MeV);
+    analysisManager->FillH1(0, sampledEnergy / MeV, weight);
 }
 
 } // namespace B4
\ No newline at end of file
@@ -0,0 +1,212 @@
+/// \file B4/B4c/src/ProfilingSteppingAction.cc
+/// \brief Implementation of the B4c::ProfilingSteppingAction and B4c::StepProfiler classes
+
+#include "ProfilingSteppingAction.hh"
+
+#include "ThreadSteppingActions.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Step.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace B4c
+{
+
+namespace
+{
+// The action installed on this worker thread, owned by its stepping manager
+G4ThreadLocal ProfilingSteppingAction* threadAction = nullptr;
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfilingSteppingAction::UserSteppingAction(const G4Step* step)
+{
+  if (!fActive) return;
+
+  const G4Track* track = step->GetTrack();
+  const G4VProcess* process = step->GetPostStepPoint()->GetProcessDefinedStep();
+  Key key{track->GetDefinition(),
+          step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume(), process};
+  auto& entry = fTable[key];
+  ++entry.steps;
+
+  // Finish the sample started at the end of the previous step of this track
+  if (fSampledTrack) {
+    if (track == fSampledTrack && track->GetCurrentStepNumber() == fSampledStepNumber + 1) {
+      entry.sampledTime += Clock::now() - fSampleStart;
+      ++entry.sampledSteps;
+    }
+    fSampledTrack = nullptr;
+  }
+
+  if (--fStepsToSample <= 0) {
+    fStepsToSample = fSampleEvery;
+    fSampledTrack = track;
+    fSampledStepNumber = track->GetCurrentStepNumber();
+    fSampleStart = Clock::now();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfilingSteppingAction::SetActive(G4bool active, G4int sampleEvery)
+{
+  fActive = active;
+  fSampleEvery = std::max(1, sampleEvery);
+  fStepsToSample = fSampleEvery;
+  fSampledTrack = nullptr;
+}
+
+void ProfilingSteppingAction::MergeAndClear()
+{
+  // Names are resolved here, once per key and run, never per step
+  auto& profiler = StepProfiler::Instance();
+  for (const auto& [key, entry] : fTable) {
+    const auto* particle = std::get<0>(key);
+    const auto* volume = std::get<1>(key);
+    const auto* process = std::get<2>(key);
+    profiler.Merge(particle->GetParticleName(), volume->GetName(),
+                   process ? process->GetProcessName() : G4String("none"), entry.steps,
+                   entry.sampledSteps, std::chrono::duration<G4double>(entry.sampledTime).count());
+  }
+  fTable.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfiler& StepProfiler::Instance()
+{
+  static StepProfiler instance;
+  return instance;
+}
+
+StepProfiler::StepProfiler()
+{
+  // Settings are shared by all threads and only read by the workers, so the
+  // commands are executed on the master only
+  fMessenger = std::make_unique<G4GenericMessenger>(this, "/B4c/profile/", "Step profiler");
+  fMessenger->DeclareProperty("enable", fEnabled, "Profile steps by particle, volume and process")
+    .command->SetToBeBroadcasted(false);
+  auto& sampleCmd =
+    fMessenger->DeclareProperty("sampleEvery", fSampleEvery, "Time one step in N per thread");
+  sampleCmd.SetParameterName("N", false).SetRange("N >= 1");
+  sampleCmd.command->SetToBeBroadcasted(false);
+  auto& topCmd = fMessenger->DeclareProperty("top", fTop, "Lines of the ranked report");
+  topCmd.SetParameterName("lines", false).SetRange("lines >= 1");
+  topCmd.command->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::BeginOfRun(G4bool isMaster)
+{
+  if (isMaster) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStats.clear();
+  }
+  if (isMaster && G4Threading::IsMultithreadedApplication()) return;
+
+  // Register the stepping action the first time profiling is wanted
+  if (!threadAction && fEnabled) {
+    threadAction = new ProfilingSteppingAction();
+    AddThreadSteppingAction(threadAction);
+  }
+  if (threadAction) threadAction->SetActive(fEnabled, fSampleEvery);
+}
+
+void StepProfiler::EndOfRun(G4bool isMaster)
+{
+  if (!fEnabled) return;
+  // In sequential mode the master runs the event loop itself
+  if (threadAction) threadAction->MergeAndClear();
+  if (isMaster) Report();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::Merge(const G4String& particle, const G4String& volume,
+                         const G4String& process, std::uint64_t steps, std::uint64_t sampledSteps,
+                         G4double sampledSeconds)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto& stats = fStats[{particle, volume, process}];
+  stats.steps += steps;
+  stats.sampledSteps += sampledSteps;
+  stats.sampledSeconds += sampledSeconds;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::Report() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+
+  using Row = std::pair<std::tuple<G4String, G4String, G4String>, Stats>;
+  std::vector<Row> rows(fStats.begin(), fStats.end());
+  std::map<G4String, Stats> byParticle, byVolume;
+  Stats total;
+  for (const auto& [key, stats] : rows) {
+    for (auto* sum : {&total, &byParticle[std::get<0>(key)], &byVolume[std::get<1>(key)]}) {
+      sum->steps += stats.steps;
+      sum->sampledSteps += stats.sampledSteps;
+      sum->sampledSeconds += stats.sampledSeconds;
+    }
+  }
+  std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+    return a.second.EstimatedSeconds() > b.second.EstimatedSeconds();
+  });
+
+  // Shares of the estimated time are sums over keys, so they add up
+  G4double totalSeconds = 0.;
+  for (const auto& row : rows) totalSeconds += row.second.EstimatedSeconds();
+  auto percent = [](G4double part, G4double all) { return all > 0. ? 100. * part / all : 0.; };
+
+  G4cout << G4endl << "[StepProfiler] " << total.steps << " steps, " << total.sampledSteps
+         << " timed, estimated " << totalSeconds << " thread-seconds" << G4endl;
+  G4cout << std::left << std::setw(12) << "particle" << std::setw(14) << "volume"
+         << std::setw(16) << "process" << std::right << std::setw(14) << "steps"
+         << std::setw(8) << "%steps" << std::setw(12) << "est. s" << std::setw(8) << "%time"
+         << std::setw(10) << "ns/step" << G4endl;
+  G4int lines = 0;
+  for (const auto& [key, stats] : rows) {
+    if (lines++ == fTop) break;
+    G4double seconds = stats.EstimatedSeconds();
+    G4cout << std::left << std::setw(12) << std::get<0>(key) << std::setw(14) << std::get<1>(key)
+           << std::setw(16) << std::get<2>(key) << std::right << std::setw(14) << stats.steps
+           << std::setw(8) << std::setprecision(3) << percent(stats.steps, total.steps)
+           << std::setw(12) << seconds << std::setw(8) << percent(seconds, totalSeconds)
+           << std::setw(10) << (stats.steps > 0 ? 1e9 * seconds / stats.steps : 0.)
+           << std::setprecision(6) << G4endl;
+  }
+
+  for (const auto& [title, sums] : {std::make_pair("particle", &byParticle),
+                                    std::make_pair("volume", &byVolume)}) {
+    G4cout << "[StepProfiler] by " << title << ":";
+    for (const auto& [name, stats] : *sums)
+      G4cout << "  " << name << " " << std::setprecision(3)
+             << percent(stats.EstimatedSeconds(), totalSeconds) << "%" << std::setprecision(6);
+    G4cout << G4endl;
+  }
+
+  std::ofstream out("data/step_profile.csv", std::ios::out | std::ios::trunc);
+  if (!out.is_open()) return;
+  out << "Particle,Volume,Process,Steps,SampledSteps,SampledSeconds,EstimatedSeconds\n";
+  for (const auto& [key, stats] : rows)
+    out << std::get<0>(key) << "," << std::get<1>(key) << "," << std::get<2>(key) << ","
+        << stats.steps << "," << stats.sampledSteps << "," << stats.sampledSeconds << ","
+        << stats.EstimatedSeconds() << "\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -5,6 +5,14 @@
 
 #include "RunAction.hh"
 
+#include "DetectorConstruction.hh"
+#include "PhotonOrigin.hh"
+#include "PointDetectorEstimator.hh"
+#include "ProfilingSteppingAction.hh"
+#include "SpectrumRegistry.hh"
+#include "SpectrumSnapshotWriter.hh"
+#include "TracingSteppingAction.hh"
+
 #include "G4AnalysisManager.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
@@ -50,10 +58,27 @@ RunAction::RunAction()
   analysisManager->CreateNtupleDColumn("Labs");
   analysisManager->CreateNtupleDColumn("Lgap");
   analysisManager->FinishNtuple();
+
+  // Commands
+  fMessenger = std::make_unique<G4GenericMessenger>(this, "/B4c/run/", "Run control");
+  fMessenger
+    ->DeclarePropertyWithUnit("snapshotInterval", "s", fSnapshotInterval,
+                              "Interval between spectrum snapshots during a run (0 = off)")
+    .SetParameterName("interval", false)
+    .SetRange("interval >= 0.");
+  fMessenger
+    ->DeclareProperty("batchSize", fBatchSize,
+                      "Events per thread and batch for batch-means errors (0 = off)")
+    .SetParameterName("events", false)
+    .SetRange("events >= 0");
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+RunAction::~RunAction() = default;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void RunAction::BeginOfRunAction(const G4Run* /*run*/)
 {
   // inform the runManager to save random number seed
@@ -71,6 +96,24 @@ void RunAction::BeginOfRunAction(const G4Run* /*run*/)
   // G4String fileName = "B4.xml";
   analysisManager->OpenFile(fileName);
   G4cout << "Using " << analysisManager->GetType() << G4endl;
+
+  // Native spectrum: zeroed before the workers start, snapshots while running
+  if (isMaster) {
+    B4c::SpectrumRegistry::Instance().Reset(fBatchSize);
+
+    auto detConst = static_cast<const B4c::DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (fSnapshotInterval > 0. && detConst->GetSpectraEnabled()) {
+      fSnapshotWriter = std::make_unique<B4c::SpectrumSnapshotWriter>(
+        detConst->GetSpectrumFileName(), detConst->GetSpectrumLabels(), fSnapshotInterval / s);
+    }
+  }
+
+  // Step profiler, point detectors and event traces: workers register
+  // their stepping actions on first use
+  B4c::StepProfiler::Instance().BeginOfRun(isMaster);
+  B4c::PointDetectorStore::Instance().BeginOfRun(isMaster);
+  B4c::EventTracer::Instance().BeginOfRun(isMaster);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -106,6 +149,46 @@ void RunAction::EndOfRunAction(const G4Run* /*run*/)
   //
   analysisManager->Write();
   analysisManager->CloseFile();
+
+  // Workers merge their step tables, then the master ranks them
+  B4c::StepProfiler::Instance().EndOfRun(isMaster);
+
+  // Final spectrum: the workers are done, so the merge is exact
+  auto detConst = static_cast<const B4c::DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  if (isMaster && detConst->GetSpectraEnabled()) {
+    fSnapshotWriter.reset();
+
+    if (B4c::SpectrumRegistry::Instance().WriteCSV(detConst->GetSpectrumFileName(),
+                                                   detConst->GetSpectrumLabels()))
+    {
+      G4cout << "[RunAction] Spectrum written to " << detConst->GetSpectrumFileName() << G4endl;
+    }
+    else {
+      G4cerr << "[RunAction] Warning: could not write " << detConst->GetSpectrumFileName()
+             << G4endl;
+    }
+
+    // Spectra by origin are only filled for photons (GammaFilter)
+    if (detConst->GetScoredParticles() != "charged") {
+      if (B4c::SpectrumRegistry::Instance().WriteCSV(detConst->GetOriginSpectrumFileName(),
+                                                     detConst->GetOriginSpectrumLabels(),
+                                                     B4c::kOriginSpectrumKey))
+      {
+        G4cout << "[RunAction] Spectra by photon origin written to "
+               << detConst->GetOriginSpectrumFileName() << G4endl;
+      }
+      else {
+        G4cerr << "[RunAction] Warning: could not write "
+               << detConst->GetOriginSpectrumFileName() << G4endl;
+      }
+    }
+  }
+
+  B4c::PointDetectorStore::Instance().EndOfRun(isMaster);
+
+  // Workers write their trace buffers, the master sums them up
+  B4c::EventTracer::Instance().EndOfRun(isMaster);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
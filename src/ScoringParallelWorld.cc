@@ -0,0 +1,68 @@
+/// \file B4/B4c/src/ScoringParallelWorld.cc
+/// \brief Implementation of the B4c::ScoringParallelWorld class
+
+#include "ScoringParallelWorld.hh"
+
+#include "CalorimeterSD.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4SDManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <vector>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ScoringParallelWorld::ScoringParallelWorld(const DetectorConstruction* detector)
+  : G4VUserParallelWorld(kWorldName), fDetector(detector)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringParallelWorld::Construct()
+{
+  // The mass geometry is built first, so the layer positions are known
+  const auto& layers = fDetector->GetLayers();
+  auto ghostWorld = GetWorld()->GetLogicalVolume();
+
+  // Slab boundaries: front of the first layer, every interface, and the
+  // back of the extra slab behind the last layer
+  std::vector<G4double> z{layers.front().zFront};
+  for (const auto& layer : layers)
+    z.push_back(layer.zBack);
+  z.push_back(layers.back().zBack + 1. * cm);
+
+  G4double slabXY = 2.0 * cm;
+
+  // One slab per layer and one behind the stack, all named "Detector" like
+  // the old planes (the hit records carry the name); copy number = slab index
+  for (std::size_t k = 0; k + 1 < z.size(); ++k) {
+    auto solid = new G4Box("Detector", slabXY / 2., slabXY / 2., (z[k + 1] - z[k]) / 2.);
+    auto logical = new G4LogicalVolume(solid, nullptr, "Detector");
+    new G4PVPlacement(nullptr, G4ThreeVector(0., 0., (z[k] + z[k + 1]) / 2.), logical,
+                      "Detector", ghostWorld, false, static_cast<G4int>(k), true);
+    fSlabLogicals.push_back(logical);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringParallelWorld::ConstructSD()
+{
+  // The filter and sink combination geometry.txt asks for
+  auto calorSD = CreateCalorimeterSD("DetectorSD");
+  G4SDManager::GetSDMpointer()->AddNewDetector(calorSD);
+
+  for (auto* logical : fSlabLogicals)
+    SetSensitiveDetector(logical, calorSD);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
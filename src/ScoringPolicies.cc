@@ -0,0 +1,19 @@
+/// \file B4/B4c/src/ScoringPolicies.cc
+/// \brief Implementation of the B4c::CalorimeterSD sink policies (HistogramSink is
+/// a template and lives in the header)
+
+#include "ScoringPolicies.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CsvRecordSink::CsvRecordSink(std::ofstream&& out) : fOut(std::move(out))
+{
+  fOut << "EventID,TrackID,ParentID,Particle,KineticEnergy,Volume,DetectorID,Weight\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
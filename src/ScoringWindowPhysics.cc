@@ -0,0 +1,26 @@
+/// \file B4/B4c/src/ScoringWindowPhysics.cc
+/// \brief Implementation of the B4c::ScoringWindowPhysics class
+
+#include "ScoringWindowPhysics.hh"
+
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4PhysicsListHelper.hh"
+#include "G4UserSpecialCuts.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringWindowPhysics::ConstructProcess()
+{
+  auto specialCuts = new G4UserSpecialCuts();
+  auto helper = G4PhysicsListHelper::GetPhysicsListHelper();
+  helper->RegisterProcess(specialCuts, G4Gamma::Definition());
+  helper->RegisterProcess(specialCuts, G4Electron::Definition());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
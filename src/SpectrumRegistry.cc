@@ -0,0 +1,207 @@
+/// \file B4/B4c/src/SpectrumRegistry.cc
+/// \brief Implementation of the B4c::ThreadSpectrum and B4c::SpectrumRegistry classes
+
+#include "SpectrumRegistry.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThreadSpectrum::ThreadSpectrum(G4int nofBins, G4double emin, G4double emax)
+  : fNofBins(nofBins),
+    fEmin(emin),
+    fEmax(emax),
+    fInvBinWidth(nofBins / (emax - emin)),
+    fSumW(new std::atomic<G4double>[nofBins]),
+    fSumW2(new std::atomic<G4double>[nofBins]),
+    fEventBins(nofBins, 0.)
+{
+  Reset(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ThreadSpectrum::EndOfEvent()
+{
+  for (auto i : fTouchedBins) {
+    G4double x = fEventBins[i];
+    Add(fSumW[i], x);
+    Add(fSumW2[i], x * x);
+    if (fBatchSize > 0) fBatchBins[i] += x;
+    fEventBins[i] = 0.;
+  }
+  fTouchedBins.clear();
+  fNofEvents.store(fNofEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  if (fBatchSize > 0 && ++fEventsInBatch == fBatchSize) {
+    {
+      std::lock_guard<std::mutex> lock(fBatchMutex);
+      fBatches.push_back(fBatchBins);
+    }
+    std::fill(fBatchBins.begin(), fBatchBins.end(), 0.);
+    fEventsInBatch = 0;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ThreadSpectrum::CopyBatches(std::vector<std::vector<G4double>>& batches) const
+{
+  std::lock_guard<std::mutex> lock(fBatchMutex);
+  batches.insert(batches.end(), fBatches.begin(), fBatches.end());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ThreadSpectrum::Reset(G4int batchSize)
+{
+  for (G4int i = 0; i < fNofBins; ++i) {
+    fSumW[i].store(0., std::memory_order_relaxed);
+    fSumW2[i].store(0., std::memory_order_relaxed);
+  }
+  fNofEvents.store(0, std::memory_order_relaxed);
+
+  std::fill(fEventBins.begin(), fEventBins.end(), 0.);
+  fTouchedBins.clear();
+
+  std::lock_guard<std::mutex> lock(fBatchMutex);
+  fBatchSize = batchSize;
+  fEventsInBatch = 0;
+  fBatchBins.assign(batchSize > 0 ? fNofBins : 0, 0.);
+  fBatches.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrumRegistry& SpectrumRegistry::Instance()
+{
+  static SpectrumRegistry instance;
+  return instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrumRegistry::SetBinning(G4int nofBins, G4double emin, G4double emax)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fNofBins = nofBins;
+  fEmin = emin;
+  fEmax = emax;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThreadSpectrum* SpectrumRegistry::CreateThreadSpectrum(G4int key)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto spectrum = std::make_unique<ThreadSpectrum>(fNofBins, fEmin, fEmax);
+  spectrum->Reset(fBatchSize);
+  fSpectra.emplace_back(key, std::move(spectrum));
+  return fSpectra.back().second.get();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrumRegistry::Reset(G4int batchSize)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fBatchSize = batchSize;
+  for (auto& [key, spectrum] : fSpectra)
+    spectrum->Reset(batchSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrumRegistry::Merge(G4int key, MergedSpectrum& merged) const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  merged.sumW.assign(fNofBins, 0.);
+  merged.sumW2.assign(fNofBins, 0.);
+  merged.nofEvents = 0;
+  merged.batchSize = fBatchSize;
+  merged.batches.clear();
+
+  for (const auto& [spectrumKey, spectrum] : fSpectra) {
+    if (spectrumKey != key) continue;
+    if (spectrum->GetNofBins() != fNofBins) continue;  // stale binning
+    for (G4int i = 0; i < fNofBins; ++i) {
+      merged.sumW[i] += spectrum->GetSumW(i);
+      merged.sumW2[i] += spectrum->GetSumW2(i);
+    }
+    merged.nofEvents += spectrum->GetNofEvents();
+    if (fBatchSize > 0) spectrum->CopyBatches(merged.batches);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrumRegistry::WriteCSV(const G4String& fileName,
+                                  const std::vector<G4String>& columnLabels,
+                                  G4int firstKey) const
+{
+  auto nofPlanes = static_cast<G4int>(columnLabels.size());
+  std::vector<MergedSpectrum> merged(nofPlanes);
+  for (G4int plane = 0; plane < nofPlanes; ++plane)
+    Merge(firstKey + plane, merged[plane]);
+
+  // Batch means: per-event mean of every batch, error of the total scaled
+  // by the number of events
+  G4bool withBatches = nofPlanes > 0 && merged.front().batches.size() > 1;
+  std::vector<std::vector<G4double>> batchError(nofPlanes);
+  if (withBatches) {
+    for (G4int plane = 0; plane < nofPlanes; ++plane) {
+      const auto& m = merged[plane];
+      auto nofBatches = static_cast<G4int>(m.batches.size());
+      batchError[plane].assign(fNofBins, 0.);
+      if (nofBatches < 2) continue;
+      for (G4int i = 0; i < fNofBins; ++i) {
+        G4double sum = 0., sum2 = 0.;
+        for (const auto& batch : m.batches) {
+          G4double mean = batch[i] / m.batchSize;
+          sum += mean;
+          sum2 += mean * mean;
+        }
+        G4double mean = sum / nofBatches;
+        G4double variance = std::max(0., (sum2 - nofBatches * mean * mean) / (nofBatches - 1));
+        batchError[plane][i] = m.nofEvents * std::sqrt(variance / nofBatches);
+      }
+    }
+  }
+
+  G4double binWidth = (fEmax - fEmin) / fNofBins;
+  G4String tmpName = fileName + ".tmp";
+  {
+    std::ofstream out(tmpName, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out << "Energy_MeV";
+    for (const auto& label : columnLabels) {
+      out << "," << label << "," << label << "_err";
+      if (withBatches) out << "," << label << "_batch_err";
+    }
+    out << "\n";
+    for (G4int i = 0; i < fNofBins; ++i) {
+      out << std::fixed << std::setprecision(6) << fEmin + (i + 0.5) * binWidth
+          << std::defaultfloat << std::setprecision(10);
+      for (G4int plane = 0; plane < nofPlanes; ++plane) {
+        out << "," << merged[plane].sumW[i] << "," << std::sqrt(merged[plane].sumW2[i]);
+        if (withBatches) out << "," << batchError[plane][i];
+      }
+      out << "\n";
+    }
+    if (!out.good()) return false;
+  }
+
+  // rename() replaces the target atomically, readers never see a partial file
+  return std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
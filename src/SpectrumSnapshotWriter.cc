@@ -0,0 +1,54 @@
+/// \file B4/B4c/src/SpectrumSnapshotWriter.cc
+/// \brief Implementation of the B4c::SpectrumSnapshotWriter class
+
+#include "SpectrumSnapshotWriter.hh"
+
+#include "SpectrumRegistry.hh"
+
+#include <chrono>
+#include <iostream>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrumSnapshotWriter::SpectrumSnapshotWriter(const G4String& fileName,
+                                               const std::vector<G4String>& columnLabels,
+                                               G4double intervalSeconds)
+  : fFileName(fileName), fColumnLabels(columnLabels), fIntervalSeconds(intervalSeconds)
+{
+  fThread = std::thread(&SpectrumSnapshotWriter::Loop, this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrumSnapshotWriter::~SpectrumSnapshotWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fWakeUp.notify_one();
+  if (fThread.joinable()) fThread.join();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrumSnapshotWriter::Loop()
+{
+  auto interval = std::chrono::duration<G4double>(fIntervalSeconds);
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (!fWakeUp.wait_for(lock, interval, [this] { return fStop; })) {
+    lock.unlock();
+    if (!SpectrumRegistry::Instance().WriteCSV(fFileName, fColumnLabels)) {
+      // Not a Geant4 thread, so no G4cerr here
+      std::cerr << "[SpectrumSnapshotWriter] Warning: could not write " << fFileName << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
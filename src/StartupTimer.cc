@@ -0,0 +1,71 @@
+/// \file B4/B4c/src/StartupTimer.cc
+/// \brief Implementation of the B4c::StartupTimer class
+
+#include "StartupTimer.hh"
+
+#include "G4StateManager.hh"
+
+#include <iomanip>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupTimer::StartupTimer() : fStart(Clock::now()), fLast(fStart) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupTimer::Mark(const G4String& phase)
+{
+  auto now = Clock::now();
+  fPhases.emplace_back(phase, std::chrono::duration<G4double>(now - fLast).count());
+  fLast = now;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StartupTimer::Notify(G4ApplicationState requestedState)
+{
+  if (fReported) return true;
+
+  auto previousState = G4StateManager::GetStateManager()->GetPreviousState();
+
+  if (previousState == G4State_PreInit && requestedState == G4State_Init) {
+    Mark("commands before /run/initialize");
+  }
+  else if (previousState == G4State_Init && requestedState == G4State_Idle) {
+    Mark(fRunInitialization ? "physics tables (build or retrieve)"
+                            : "/run/initialize (geometry, physics list)");
+  }
+  else if (previousState == G4State_Idle && requestedState == G4State_Init) {
+    Mark("commands before first /run/beamOn");
+    fRunInitialization = true;
+  }
+  else if (requestedState == G4State_GeomClosed) {
+    Mark("run initialisation");
+    Report();
+    fReported = true;
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupTimer::Report() const
+{
+  G4double total = std::chrono::duration<G4double>(fLast - fStart).count();
+
+  G4cout << G4endl << "[StartupTimer] Startup phases (wall time):" << G4endl;
+  for (const auto& [phase, seconds] : fPhases) {
+    G4cout << "  " << std::left << std::setw(44) << phase << std::right << std::fixed
+           << std::setprecision(3) << std::setw(9) << seconds << " s" << G4endl;
+  }
+  G4cout << "  " << std::left << std::setw(44) << "total to first event" << std::right
+         << std::setw(9) << total << " s" << std::defaultfloat << G4endl << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
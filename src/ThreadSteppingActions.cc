@@ -0,0 +1,36 @@
+/// \file B4/B4c/src/ThreadSteppingActions.cc
+/// \brief Implementation of B4c::AddThreadSteppingAction
+
+#include "ThreadSteppingActions.hh"
+
+#include "G4MultiSteppingAction.hh"
+#include "G4RunManager.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AddThreadSteppingAction(G4UserSteppingAction* action)
+{
+  auto runManager = G4RunManager::GetRunManager();
+  auto current = const_cast<G4UserSteppingAction*>(runManager->GetUserSteppingAction());
+  if (!current) {
+    runManager->SetUserAction(action);
+    return;
+  }
+
+  auto multi = dynamic_cast<G4MultiSteppingAction*>(current);
+  if (!multi) {
+    multi = new G4MultiSteppingAction();
+    multi->emplace_back(current);
+  }
+  multi->emplace_back(action);
+
+  // Set again, so every action gets the stepping manager pointer
+  runManager->SetUserAction(multi);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -0,0 +1,373 @@
+/// \file B4/B4c/src/TracingSteppingAction.cc
+/// \brief Implementation of the B4c::TracingSteppingAction and B4c::EventTracer classes
+
+#include "TracingSteppingAction.hh"
+
+#include "ThreadSteppingActions.hh"
+#include "TrackInformation.hh"
+
+#include "G4Gamma.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4StateManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <fstream>
+
+namespace B4c
+{
+
+namespace
+{
+// The action and buffer of this worker thread; the action is owned by the
+// stepping manager, the buffer by the EventTracer
+G4ThreadLocal TracingSteppingAction* threadAction = nullptr;
+G4ThreadLocal TraceBuffer* threadBuffer = nullptr;
+
+// Dump requests from /B4c/trace/dump during a run or SIGUSR1; every thread
+// writes its buffer when the count changes
+std::atomic<G4int> dumpRequests{0};
+G4ThreadLocal G4int threadDumpRequestsSeen = 0;
+
+void RequestDump(int /*signal*/)
+{
+  dumpRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+constexpr char kMagic[4] = {'B', '4', 'T', 'R'};
+constexpr std::uint32_t kVersion = 1;
+
+void WriteTable(std::ofstream& out, const std::vector<G4String>& table)
+{
+  auto count = static_cast<std::uint32_t>(table.size());
+  out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  for (const auto& name : table) {
+    auto length = static_cast<std::uint16_t>(name.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(name.data(), length);
+  }
+}
+
+// Name index of a pointer key, resolved once per key and thread
+template<class AddName>
+std::uint16_t CachedIndex(std::unordered_map<const void*, std::uint16_t>& cache, const void* key,
+                          AddName addName)
+{
+  auto it = cache.find(key);
+  if (it != cache.end()) return it->second;
+  std::uint16_t index = addName();
+  cache.emplace(key, index);
+  return index;
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TraceBuffer::TraceBuffer(G4int threadID, std::size_t capacity)
+  : fThreadID(threadID), fRing(std::max<std::size_t>(1, capacity))
+{}
+
+void TraceBuffer::Clear()
+{
+  fHead = 0;
+  fSize = 0;
+  fNofEvents = 0;
+}
+
+void TraceBuffer::Resize(std::size_t capacity)
+{
+  fRing.assign(std::max<std::size_t>(1, capacity), TraceRecord{});
+  fRing.shrink_to_fit();
+  Clear();
+}
+
+void TraceBuffer::Append(const std::vector<TraceRecord>& records)
+{
+  const std::size_t capacity = fRing.size();
+  for (const auto& record : records) {
+    fRing[fHead] = record;
+    if (++fHead == capacity) fHead = 0;
+  }
+  fSize = std::min(capacity, fSize + records.size());
+  ++fNofEvents;
+}
+
+std::uint16_t TraceBuffer::Index(std::vector<G4String>& table, const G4String& name)
+{
+  auto it = std::find(table.begin(), table.end(), name);
+  if (it != table.end()) return static_cast<std::uint16_t>(it - table.begin());
+  table.push_back(name);
+  return static_cast<std::uint16_t>(table.size() - 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TraceBuffer::Write(const G4String& fileName) const
+{
+  std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+
+  const auto recordSize = static_cast<std::uint32_t>(sizeof(TraceRecord));
+  const auto nofRecords = static_cast<std::uint64_t>(fSize);
+  const std::int32_t threadID = fThreadID;
+  out.write(kMagic, sizeof(kMagic));
+  out.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  out.write(reinterpret_cast<const char*>(&threadID), sizeof(threadID));
+  out.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+  out.write(reinterpret_cast<const char*>(&nofRecords), sizeof(nofRecords));
+  WriteTable(out, fParticles);
+  WriteTable(out, fVolumes);
+  WriteTable(out, fProcesses);
+
+  // Oldest record first: once the ring has wrapped, that is the one at the head
+  auto write = [&out](const TraceRecord* first, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(first),
+              static_cast<std::streamsize>(count * sizeof(TraceRecord)));
+  };
+  if (fSize < fRing.size()) {
+    write(fRing.data(), fSize);
+  }
+  else {
+    write(fRing.data() + fHead, fRing.size() - fHead);
+    write(fRing.data(), fHead);
+  }
+  return static_cast<bool>(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TracingSteppingAction::TracingSteppingAction(TraceBuffer* buffer)
+  : fBuffer(buffer), fGamma(G4Gamma::Definition())
+{}
+
+void TracingSteppingAction::SetSelection(G4int sampleEvery, G4double triggerEnergy)
+{
+  fSampleEvery = sampleEvery;
+  fTriggerEnergy = triggerEnergy;
+  fRecording = false;
+  fEvent.clear();
+}
+
+void TracingSteppingAction::BeginOfEvent(G4int eventID)
+{
+  fEventID = eventID;
+  fSampled = (fSampleEvery > 0) && (eventID % fSampleEvery == 0);
+  fRecording = fSampled || (fTriggerEnergy > 0.);
+  fTriggered = false;
+  fTruncated = false;
+  fEvent.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TracingSteppingAction::UserSteppingAction(const G4Step* step)
+{
+  if (!fRecording) return;
+
+  const G4Track* track = step->GetTrack();
+  const G4StepPoint* preStep = step->GetPreStepPoint();
+  const G4StepPoint* postStep = step->GetPostStepPoint();
+  const G4ParticleDefinition* particle = track->GetDefinition();
+
+  // The scoring SD has already seen this step and marked the track, with
+  // the pre-step energy it scored
+  if (fTriggerEnergy > 0. && !fTriggered && particle == fGamma
+      && preStep->GetKineticEnergy() >= fTriggerEnergy)
+  {
+    auto* info = static_cast<const TrackInformation*>(track->GetUserInformation());
+    fTriggered = info && info->IsScoredOnAnyPlane();
+  }
+
+  if (fEvent.size() >= fBuffer->GetCapacity()) {
+    fTruncated = true;
+    return;
+  }
+
+  const G4VPhysicalVolume* volume = preStep->GetPhysicalVolume();
+  const G4LogicalVolume* logical = volume->GetLogicalVolume();
+  const G4VProcess* process = postStep->GetProcessDefinedStep();
+  const G4ThreeVector& position = postStep->GetPosition();
+
+  TraceRecord record;
+  record.eventID = fEventID;
+  record.trackID = track->GetTrackID();
+  record.parentID = track->GetParentID();
+  record.stepNumber = track->GetCurrentStepNumber();
+  record.particle = CachedIndex(fParticleIndex, particle, [&] {
+    return fBuffer->ParticleIndex(particle->GetParticleName());
+  });
+  record.volume = CachedIndex(fVolumeIndex, logical,
+                              [&] { return fBuffer->VolumeIndex(logical->GetName()); });
+  record.process = CachedIndex(fProcessIndex, process, [&] {
+    return fBuffer->ProcessIndex(process ? process->GetProcessName() : G4String("none"));
+  });
+  record.copyNo = static_cast<std::int16_t>(volume->GetCopyNo());
+  record.flags = 0;
+  record.preEnergy = static_cast<float>(preStep->GetKineticEnergy() / MeV);
+  record.postEnergy = static_cast<float>(postStep->GetKineticEnergy() / MeV);
+  record.edep = static_cast<float>(step->GetTotalEnergyDeposit() / MeV);
+  record.x = static_cast<float>(position.x() / mm);
+  record.y = static_cast<float>(position.y() / mm);
+  record.z = static_cast<float>(position.z() / mm);
+  record.weight = static_cast<float>(preStep->GetWeight());
+  fEvent.push_back(record);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TracingSteppingAction::EndOfEvent()
+{
+  if (!fRecording) return;
+  fRecording = false;
+
+  if ((fSampled || fTriggered) && !fEvent.empty()) {
+    fEvent.front().flags = kTraceEventStart | (fSampled ? kTraceSampled : 0u)
+                           | (fTriggered ? kTraceTriggered : 0u)
+                           | (fTruncated ? kTraceTruncated : 0u);
+    fBuffer->Append(fEvent);
+  }
+  fEvent.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventTracer& EventTracer::Instance()
+{
+  static EventTracer instance;
+  return instance;
+}
+
+EventTracer::EventTracer()
+{
+  // Settings are shared by all threads and only read by the workers, so the
+  // commands are executed on the master only
+  fMessenger = std::make_unique<G4GenericMessenger>(this, "/B4c/trace/", "Event step traces");
+  auto& sampleCmd = fMessenger->DeclareProperty("sampleEvery", fSampleEvery,
+                                                "Trace one event in N per thread (0 = off)");
+  sampleCmd.SetParameterName("N", false).SetRange("N >= 0");
+  sampleCmd.command->SetToBeBroadcasted(false);
+  auto& triggerCmd = fMessenger->DeclarePropertyWithUnit(
+    "trigger", "MeV", fTriggerEnergy, "Trace events scoring a photon above this energy (0 = off)");
+  triggerCmd.SetParameterName("energy", false).SetRange("energy >= 0.");
+  triggerCmd.command->SetToBeBroadcasted(false);
+  auto& sizeCmd =
+    fMessenger->DeclareProperty("bufferSize", fBufferSize, "Steps kept per thread (ring buffer)");
+  sizeCmd.SetParameterName("steps", false).SetRange("steps >= 1");
+  sizeCmd.command->SetToBeBroadcasted(false);
+  fMessenger->DeclareMethod("dump", &EventTracer::Dump, "Write the trace buffers now")
+    .command->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String EventTracer::FileName(G4int threadID)
+{
+  if (threadID < 0) return "data/trace.b4t";
+  return "data/trace_t" + std::to_string(threadID) + ".b4t";
+}
+
+G4bool EventTracer::WriteBuffer(const TraceBuffer& buffer)
+{
+  G4String fileName = FileName(buffer.GetThreadID());
+  if (!buffer.Write(fileName)) {
+    G4cerr << "[EventTracer] Warning: could not write " << fileName << G4endl;
+    return false;
+  }
+  G4cout << "[EventTracer] " << buffer.GetSize() << " steps of the last traced events written to "
+         << fileName << G4endl;
+  return true;
+}
+
+void EventTracer::Dump()
+{
+  // During a run the buffers are being filled: the threads write their own
+  auto state = G4StateManager::GetStateManager()->GetCurrentState();
+  if (state == G4State_GeomClosed || state == G4State_EventProc) {
+    RequestDump(0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (fBuffers.empty()) G4cout << "[EventTracer] Nothing traced yet" << G4endl;
+  for (const auto& buffer : fBuffers)
+    WriteBuffer(*buffer);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTracer::BeginOfRun(G4bool isMaster)
+{
+  if (isMaster && IsEnabled() && !fSignalHandlerInstalled) {
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, RequestDump);
+#endif
+    fSignalHandlerInstalled = true;
+  }
+  if (isMaster && G4Threading::IsMultithreadedApplication()) return;
+
+  // Register the stepping action the first time tracing is wanted
+  if (!threadAction && IsEnabled()) {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fBuffers.push_back(std::make_unique<TraceBuffer>(G4Threading::G4GetThreadId(), fBufferSize));
+      threadBuffer = fBuffers.back().get();
+    }
+    threadAction = new TracingSteppingAction(threadBuffer);
+    AddThreadSteppingAction(threadAction);
+  }
+  if (!threadAction) return;
+
+  if (threadBuffer->GetCapacity() != static_cast<std::size_t>(fBufferSize))
+    threadBuffer->Resize(fBufferSize);
+  else
+    threadBuffer->Clear();
+  threadAction->SetSelection(fSampleEvery, fTriggerEnergy);
+  threadDumpRequestsSeen = dumpRequests.load(std::memory_order_relaxed);
+}
+
+void EventTracer::BeginOfEvent(G4int eventID)
+{
+  if (threadAction) threadAction->BeginOfEvent(eventID);
+}
+
+void EventTracer::EndOfEvent()
+{
+  if (!threadAction) return;
+  threadAction->EndOfEvent();
+
+  G4int requests = dumpRequests.load(std::memory_order_relaxed);
+  if (requests != threadDumpRequestsSeen) {
+    threadDumpRequestsSeen = requests;
+    WriteBuffer(*threadBuffer);
+  }
+}
+
+void EventTracer::EndOfRun(G4bool isMaster)
+{
+  if (!IsEnabled()) return;
+  // In sequential mode the master runs the event loop itself
+  if (threadAction) WriteBuffer(*threadBuffer);
+  if (!isMaster) return;
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  std::uint64_t events = 0;
+  std::size_t steps = 0;
+  for (const auto& buffer : fBuffers) {
+    events += buffer->GetNofEvents();
+    steps += buffer->GetSize();
+  }
+  G4cout << "[EventTracer] " << events << " events traced, " << steps << " steps kept in "
+         << fBuffers.size() << " buffers (plots/read_trace.py)" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -0,0 +1,11 @@
+/// \file B4/B4c/src/TrackInformation.cc
+/// \brief Implementation of the B4c::TrackInformation class
+
+#include "TrackInformation.hh"
+
+namespace B4c
+{
+
+G4ThreadLocal G4Allocator<TrackInformation>* TrackInformationAllocator = nullptr;
+
+}  // namespace B4c
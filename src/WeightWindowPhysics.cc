@@ -0,0 +1,35 @@
+/// \file B4/B4c/src/WeightWindowPhysics.cc
+/// \brief Implementation of the B4c::WeightWindowPhysics class
+
+#include "WeightWindowPhysics.hh"
+
+#include "WeightWindowProcess.hh"
+#include "WeightWindowStore.hh"
+
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Positron.hh"
+#include "G4ProcessManager.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WeightWindowPhysics::WeightWindowPhysics() : G4VPhysicsConstructor("WeightWindow")
+{
+  WeightWindowStore::Instance();
+}
+
+void WeightWindowPhysics::ConstructProcess()
+{
+  for (auto* particle : {G4Gamma::Definition(), G4Electron::Definition(),
+                         G4Positron::Definition()}) {
+    particle->GetProcessManager()->AddProcess(
+      new WeightWindowProcess(particle->GetParticleName()), ordInActive, ordInActive, ordLast);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -0,0 +1,137 @@
+/// \file B4/B4c/src/WeightWindowProcess.cc
+/// \brief Implementation of the B4c::WeightWindowProcess class
+
+#include "WeightWindowProcess.hh"
+
+#include "TrackInformation.hh"
+#include "WeightWindowStore.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParallelWorldProcess.hh"
+#include "G4Region.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WeightWindowProcess::WeightWindowProcess(const G4String& particleName)
+  : G4VProcess("WeightWindow", fGeneral),
+    fParticleName(particleName),
+    fTagOrigin(particleName == "gamma")
+{
+  pParticleChange = &fParticleChange;
+  fParticleChange.SetSecondaryWeightByProcess(true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WeightWindowProcess::StartTracking(G4Track* track)
+{
+  G4VProcess::StartTracking(track);
+
+  // The table only changes between runs
+  const auto& store = WeightWindowStore::Instance();
+  if (store.GetVersion() != fVersion) {
+    fVersion = store.GetVersion();
+    fActive = !store.IsEmpty();
+    fRegion = nullptr;
+    fWindows = nullptr;
+  }
+}
+
+G4double WeightWindowProcess::PostStepGetPhysicalInteractionLength(const G4Track&, G4double,
+                                                                   G4ForceCondition* condition)
+{
+  *condition = fActive ? StronglyForced : NotForced;
+  return DBL_MAX;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* WeightWindowProcess::PostStepDoIt(const G4Track& track, const G4Step& step)
+{
+  fParticleChange.Initialize(track);
+  if (track.GetTrackStatus() != fAlive) return &fParticleChange;
+
+  // No window on a step that ends on a boundary of the mass or the scoring
+  // world: a plane crossed there is scored with the weight of the step,
+  // and copies started on it would depend on the order of the post-step
+  // processes for their plane credit
+  const auto* postStep = step.GetPostStepPoint();
+  if (postStep->GetStepStatus() == fGeomBoundary
+      || dynamic_cast<const G4ParallelWorldProcess*>(postStep->GetProcessDefinedStep()))
+  {
+    return &fParticleChange;
+  }
+
+  auto* volume = postStep->GetPhysicalVolume();
+  if (!volume) return &fParticleChange;  // leaving the world
+
+  const G4Region* region = volume->GetLogicalVolume()->GetRegion();
+  if (region != fRegion) {
+    fRegion = region;
+    fWindows = WeightWindowStore::Instance().Find(fParticleName, region->GetName());
+  }
+  if (!fWindows) return &fParticleChange;
+
+  // Energy bin: the first one whose upper edge is above the track energy
+  G4double energy = track.GetKineticEnergy();
+  auto bin = std::upper_bound(
+    fWindows->begin(), fWindows->end(), energy,
+    [](G4double e, const WeightWindow& window) { return e < window.eMax; });
+  if (bin == fWindows->end()) return &fParticleChange;
+
+  const auto& store = WeightWindowStore::Instance();
+  G4double weight = track.GetWeight();
+  G4double lower = bin->lower;
+  G4double upper = lower * store.GetUpperRatio();
+  G4double survival = lower * store.GetSurvivalRatio();
+
+  if (weight < lower) {
+    // Russian roulette
+    if (G4UniformRand() * survival < weight)
+      fParticleChange.ProposeWeight(survival);
+    else
+      fParticleChange.ProposeTrackStatus(fStopAndKill);
+  }
+  else if (weight > upper) {
+    // Splitting; the track keeps one piece, the others start here
+    auto nofPieces =
+      std::min(store.GetMaxSplit(), static_cast<G4int>(std::ceil(weight / survival)));
+    if (nofPieces < 2) return &fParticleChange;
+    G4double pieceWeight = weight / nofPieces;
+
+    fParticleChange.ProposeWeight(pieceWeight);
+    fParticleChange.SetNumberOfSecondaries(nofPieces - 1);
+    auto* info = static_cast<TrackInformation*>(track.GetUserInformation());
+    G4int origin = fTagOrigin ? fOriginClassifier.Classify(track) : -1;
+    for (G4int i = 1; i < nofPieces; ++i) {
+      auto* piece = new G4Track(new G4DynamicParticle(*track.GetDynamicParticle()),
+                                track.GetGlobalTime(), track.GetPosition());
+      piece->SetTouchableHandle(track.GetTouchableHandle());
+      piece->SetWeight(pieceWeight);
+      // Copies have already been scored wherever the original was, and
+      // photons keep the origin of the original
+      if (info || fTagOrigin) {
+        auto* pieceInfo = info ? new TrackInformation(*info) : new TrackInformation();
+        pieceInfo->SetOrigin(origin);
+        piece->SetUserInformation(pieceInfo);
+      }
+      fParticleChange.AddSecondary(piece);
+    }
+  }
+  return &fParticleChange;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c
@@ -0,0 +1,149 @@
+/// \file B4/B4c/src/WeightWindowStore.cc
+/// \brief Implementation of the B4c::WeightWindowStore class
+
+#include "WeightWindowStore.hh"
+
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcommand.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIparameter.hh"
+#include "G4UnitsTable.hh"
+
+#include <algorithm>
+#include <sstream>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WeightWindowStore& WeightWindowStore::Instance()
+{
+  static WeightWindowStore instance;
+  return instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WeightWindowStore::WeightWindowStore()
+{
+  fDirectory = std::make_unique<G4UIdirectory>("/B4c/ww/", false);
+  fDirectory->SetGuidance("Weight windows by particle, region and energy");
+
+  fWindowCmd = std::make_unique<G4UIcommand>("/B4c/ww/window", this);
+  fWindowCmd->SetGuidance("Lower weight bound below Emax for a particle in a region.");
+  fWindowCmd->SetGuidance("Bins of one particle and region are sorted by Emax.");
+  auto particle = new G4UIparameter("particle", 's', false);
+  particle->SetParameterCandidates("gamma e- e+");
+  fWindowCmd->SetParameter(particle);
+  fWindowCmd->SetParameter(new G4UIparameter("region", 's', false));
+  auto eMax = new G4UIparameter("Emax", 'd', false);
+  eMax->SetParameterRange("Emax > 0.");
+  fWindowCmd->SetParameter(eMax);
+  auto unit = new G4UIparameter("unit", 's', false);
+  unit->SetParameterCandidates(G4UIcommand::UnitsList("Energy"));
+  fWindowCmd->SetParameter(unit);
+  auto lower = new G4UIparameter("lower", 'd', false);
+  lower->SetParameterRange("lower > 0.");
+  fWindowCmd->SetParameter(lower);
+
+  fUpperRatioCmd = std::make_unique<G4UIcmdWithADouble>("/B4c/ww/upperRatio", this);
+  fUpperRatioCmd->SetGuidance("Upper weight bound as a multiple of the lower one");
+  fUpperRatioCmd->SetParameterName("ratio", false);
+  fUpperRatioCmd->SetRange("ratio > 1.");
+
+  fMaxSplitCmd = std::make_unique<G4UIcmdWithAnInteger>("/B4c/ww/maxSplit", this);
+  fMaxSplitCmd->SetGuidance("Maximum number of pieces a track is split into");
+  fMaxSplitCmd->SetParameterName("n", false);
+  fMaxSplitCmd->SetRange("n >= 2");
+
+  fClearCmd = std::make_unique<G4UIcmdWithoutParameter>("/B4c/ww/clear", this);
+  fClearCmd->SetGuidance("Remove all weight windows");
+
+  fListCmd = std::make_unique<G4UIcmdWithoutParameter>("/B4c/ww/list", this);
+  fListCmd->SetGuidance("Print the weight-window table");
+
+  // The table is shared: the master edits it, the workers only read it
+  for (G4UIcommand* command : {fWindowCmd.get(), static_cast<G4UIcommand*>(fUpperRatioCmd.get()),
+                               static_cast<G4UIcommand*>(fMaxSplitCmd.get()),
+                               static_cast<G4UIcommand*>(fClearCmd.get()),
+                               static_cast<G4UIcommand*>(fListCmd.get())})
+    command->SetToBeBroadcasted(false);
+}
+
+WeightWindowStore::~WeightWindowStore() = default;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WeightWindowStore::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fWindowCmd.get()) {
+    std::istringstream is(newValue);
+    G4String particle, region, unit;
+    G4double eMax = 0., lower = 0.;
+    is >> particle >> region >> eMax >> unit >> lower;
+    AddWindow(particle, region, eMax * G4UIcommand::ValueOf(unit), lower);
+  }
+  else if (command == fUpperRatioCmd.get()) {
+    fUpperRatio = fUpperRatioCmd->GetNewDoubleValue(newValue);
+    ++fVersion;
+  }
+  else if (command == fMaxSplitCmd.get()) {
+    fMaxSplit = fMaxSplitCmd->GetNewIntValue(newValue);
+    ++fVersion;
+  }
+  else if (command == fClearCmd.get()) {
+    fWindows.clear();
+    ++fVersion;
+  }
+  else if (command == fListCmd.get()) {
+    List();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WeightWindowStore::AddWindow(const G4String& particle, const G4String& region,
+                                  G4double eMax, G4double lower)
+{
+  // The world volume is in Geant4's default region
+  G4String regionName = (region == "World") ? G4String("DefaultRegionForTheWorld") : region;
+
+  auto& bins = fWindows[{particle, regionName}];
+  auto sameEdge = [eMax](const WeightWindow& w) { return w.eMax == eMax; };
+  bins.erase(std::remove_if(bins.begin(), bins.end(), sameEdge), bins.end());
+  bins.push_back({eMax, lower});
+  std::sort(bins.begin(), bins.end(),
+            [](const WeightWindow& a, const WeightWindow& b) { return a.eMax < b.eMax; });
+  ++fVersion;
+}
+
+const std::vector<WeightWindow>* WeightWindowStore::Find(const G4String& particle,
+                                                         const G4String& region) const
+{
+  auto it = fWindows.find({particle, region});
+  return (it == fWindows.end()) ? nullptr : &it->second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WeightWindowStore::List() const
+{
+  G4cout << "[WeightWindowStore] upper = " << fUpperRatio << " x lower, survival = "
+         << GetSurvivalRatio() << " x lower, at most " << fMaxSplit << " pieces" << G4endl;
+  for (const auto& [key, bins] : fWindows) {
+    G4double eLow = 0.;
+    for (const auto& bin : bins) {
+      G4cout << "  " << key.first << " in " << key.second << ", " << G4BestUnit(eLow, "Energy")
+             << "- " << G4BestUnit(bin.eMax, "Energy") << ": [" << bin.lower << ", "
+             << bin.lower * fUpperRatio << "]" << G4endl;
+      eLow = bin.eMax;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B4c